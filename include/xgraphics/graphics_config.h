@@ -1,12 +1,20 @@
 #ifndef WPEX_GRAPHICS_CONFIG_H
 #define WPEX_GRAPHICS_CONFIG_H
 
+#include "interfaces/graphics_swapchain.h"
 #include "xgraphics_backend.h"
+#include <vector>
 
 struct graphics_config {
     xgraphics_backend backend;
     void* native_window_handle;
     int frames_in_flight = 2;
+
+    // Present modes in order of preference, falling back to FIFO when none of them are supported
+    std::vector<graphics_present_mode> present_modes = {graphics_present_mode::fifo};
+
+    // Clamped to what the surface supports, and one more than its minimum when 0
+    uint32_t swapchain_images = 0;
 };
 
 #endif
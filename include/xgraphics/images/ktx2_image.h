@@ -0,0 +1,48 @@
+#ifndef WPEX_KTX2_IMAGE_H
+#define WPEX_KTX2_IMAGE_H
+
+#include "../interfaces/graphics_device.h"
+#include "../interfaces/graphics_image.h"
+#include <cstdint>
+#include <result/result.h>
+#include <string>
+#include <vector>
+
+struct ktx2_level {
+    const uint8_t* data;
+    uint64_t size;
+};
+
+// A memory mapped .ktx2 file, whose levels are uploaded as stored without decoding them on the CPU. On Windows the
+// file is read into memory instead.
+class ktx2_image {
+    void* _mapping;
+    uint64_t _mapping_size;
+    graphics_image_init _init;
+    std::vector<ktx2_level> _levels;
+
+    ktx2_image(void* mapping, uint64_t mapping_size, const graphics_image_init& init, std::vector<ktx2_level> levels);
+
+  public:
+    ktx2_image(const ktx2_image&) = delete;
+    ~ktx2_image();
+
+    // Supercompressed files and cube map arrays are not supported
+    static result::ptr<ktx2_image> open(const std::string& path);
+
+    [[nodiscard]] graphics_image_format format() const;
+    [[nodiscard]] graphics_image_type type() const;
+    [[nodiscard]] uint32_t width() const;
+    [[nodiscard]] uint32_t height() const;
+    [[nodiscard]] uint32_t depth() const;
+    [[nodiscard]] uint32_t layers() const;
+    [[nodiscard]] uint32_t mip_levels() const;
+
+    // Every layer of the level, one after another
+    [[nodiscard]] const ktx2_level& level(uint32_t mip_level) const;
+
+    // Creates an immutable image with every level of the file, without waiting for the writes
+    result::ptr<graphics_image> upload(graphics_device& device) const;
+};
+
+#endif
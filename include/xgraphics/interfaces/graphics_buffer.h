@@ -1,12 +1,17 @@
 #ifndef WPEX_GRAPHICS_BUFFER_H
 #define WPEX_GRAPHICS_BUFFER_H
 
+#include "graphics_readback.h"
+#include "graphics_transfer.h"
 #include <cstdint>
+#include <memory>
 
 struct buffer_usage {
     enum buffer_usage_bits {
         vertex = 1 << 0,
         index = 1 << 1,
+        uniform = 1 << 2,
+        indirect = 1 << 3,
     };
 };
 
@@ -14,19 +19,35 @@ typedef uint32_t buffer_usage_flags;
 
 class graphics_buffer {
     buffer_usage_flags _usage;
-    uint32_t _size;
+    uint64_t _size;
+    bool _immutable = false;
 
   protected:
-    explicit graphics_buffer(buffer_usage_flags usage, uint32_t size);
+    explicit graphics_buffer(buffer_usage_flags usage, uint64_t size);
 
   public:
     graphics_buffer(const graphics_buffer&) = delete;
     virtual ~graphics_buffer() = default;
 
     [[nodiscard]] buffer_usage_flags usage() const;
-    [[nodiscard]] uint32_t size() const;
+    [[nodiscard]] uint64_t size() const;
 
-    virtual void write(const void* data, uint32_t size) = 0;
+    // Immutable buffers reject any further writes
+    [[nodiscard]] bool immutable() const;
+    void make_immutable();
+
+    void write(const void* data, uint64_t size);
+    graphics_transfer_token write_async(const void* data, uint64_t size);
+
+    virtual void write(uint64_t offset, const void* data, uint64_t size) = 0;
+    virtual graphics_transfer_token write_async(uint64_t offset, const void* data, uint64_t size) = 0;
+
+    // Records the data now, but only uploads it with the next command buffer submission. Ranges written before then
+    // are merged, and uploaded together with a single copy command.
+    virtual void write_deferred(uint64_t offset, const void* data, uint64_t size) = 0;
+
+    std::unique_ptr<graphics_readback> read_async();
+    virtual std::unique_ptr<graphics_readback> read_async(uint64_t offset, uint64_t size) = 0;
 };
 
 #endif
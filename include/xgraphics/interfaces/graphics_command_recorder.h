@@ -0,0 +1,98 @@
+#ifndef WPEX_GRAPHICS_COMMAND_RECORDER_H
+#define WPEX_GRAPHICS_COMMAND_RECORDER_H
+
+#include "graphics_buffer.h"
+#include "graphics_pipeline.h"
+#include "graphics_resource_set.h"
+#include <span>
+
+enum class index_type {
+    uint_16,
+    uint_32,
+};
+
+struct graphics_vertex_buffer_binding {
+    const graphics_buffer* buffer;
+    uint64_t offset = 0;
+};
+
+// The records read by indirect draws, which match the layout of the draw arguments of every backend
+struct graphics_draw_indirect_command {
+    uint32_t vertex_count;
+    uint32_t instance_count;
+    uint32_t vertex_start;
+    uint32_t instance_start;
+};
+
+struct graphics_draw_indexed_indirect_command {
+    uint32_t index_count;
+    uint32_t instance_count;
+    uint32_t index_start;
+    int32_t vertex_offset;
+    uint32_t instance_start;
+};
+
+// Counts the commands recorded since the command buffer began, which is once per frame. Binds of state that is
+// already bound are skipped, and counted separately. Every vertex buffer index that is bound counts as a bind, and
+// every indirect draw command as a single draw.
+struct graphics_command_stats {
+    uint32_t draws = 0;
+    uint32_t pipeline_binds = 0;
+    uint32_t vertex_buffer_binds = 0;
+    uint32_t index_buffer_binds = 0;
+    uint32_t resource_set_binds = 0;
+    uint32_t elided_pipeline_binds = 0;
+    uint32_t elided_vertex_buffer_binds = 0;
+    uint32_t elided_index_buffer_binds = 0;
+    uint32_t elided_resource_set_binds = 0;
+};
+
+// The commands recorded inside a render pass, shared by primary and secondary command buffers
+class graphics_command_recorder {
+  public:
+    explicit graphics_command_recorder() = default;
+    graphics_command_recorder(const graphics_command_recorder&) = delete;
+    virtual ~graphics_command_recorder() = default;
+
+    virtual void bind_pipeline(const graphics_pipeline& pipeline) = 0;
+    void bind_vertex_buffer(const graphics_buffer& buffer, uint64_t offset, int index);
+
+    // Binds the buffers to consecutive indices from the first one, such as the separate streams of a mesh
+    virtual void bind_vertex_buffers(uint32_t first_index,
+                                     std::span<const graphics_vertex_buffer_binding> buffers) = 0;
+    virtual void bind_index_buffer(const graphics_buffer& buffer, uint64_t offset, index_type type) = 0;
+    virtual void bind_resource_set(const graphics_resource_set& resource_set) = 0;
+
+    void draw(uint32_t vertex_start, uint32_t vertex_count);
+    virtual void draw(uint32_t vertex_start, uint32_t vertex_count, uint32_t instance_start,
+                      uint32_t instance_count) = 0;
+
+    // Draws with the bound index buffer
+    void draw_indexed(uint32_t index_start, uint32_t index_count, uint32_t vertex_offset);
+    virtual void draw_indexed(uint32_t index_start, uint32_t index_count, uint32_t vertex_offset,
+                              uint32_t instance_start, uint32_t instance_count) = 0;
+
+    // Binds the index buffer, and then draws with it
+    void draw_indexed(const graphics_buffer& index_buffer, uint64_t index_offset, index_type type, uint32_t index_start,
+                      uint32_t index_count, uint32_t vertex_offset);
+    void draw_indexed(const graphics_buffer& index_buffer, uint64_t index_offset, index_type type, uint32_t index_start,
+                      uint32_t index_count, uint32_t vertex_offset, uint32_t instance_start, uint32_t instance_count);
+
+    // Draws the tightly packed records in the buffer, which must have been created with indirect usage. Records with a
+    // non-zero instance start might not be supported by every Vulkan device.
+    virtual void draw_indirect(const graphics_buffer& buffer, uint64_t offset, uint32_t draw_count) = 0;
+    virtual void draw_indexed_indirect(const graphics_buffer& buffer, uint64_t offset, uint32_t draw_count) = 0;
+
+    // Reads the number of records to draw as a uint32_t from the count buffer, up to the maximum. Only supported when
+    // the device def has draw_indirect_count set.
+    virtual void draw_indirect_count(const graphics_buffer& buffer, uint64_t offset,
+                                     const graphics_buffer& count_buffer, uint64_t count_offset,
+                                     uint32_t max_draw_count) = 0;
+    virtual void draw_indexed_indirect_count(const graphics_buffer& buffer, uint64_t offset,
+                                             const graphics_buffer& count_buffer, uint64_t count_offset,
+                                             uint32_t max_draw_count) = 0;
+
+    [[nodiscard]] virtual graphics_command_stats stats() const = 0;
+};
+
+#endif
@@ -4,11 +4,18 @@
 #include "graphics_buffer.h"
 #include "graphics_command_buffer.h"
 #include "graphics_device_def.h"
+#include "graphics_geometry_arena.h"
+#include "graphics_memory.h"
 #include "graphics_pipeline.h"
 #include "graphics_render_pass.h"
 #include "graphics_resource_layout.h"
+#include "graphics_semaphore.h"
 #include "graphics_shader.h"
 #include "graphics_swapchain.h"
+#include "graphics_transfer.h"
+#include "graphics_transient.h"
+#include "graphics_upload_batch.h"
+#include <functional>
 #include <result/result.h>
 #include <xgraphics/graphics_config.h>
 #include <xgraphics/shaders/shader_binary.h>
@@ -18,6 +25,10 @@ class graphics_device {
     graphics_config _config;
     int _current_frame = 0;
 
+    float _memory_budget_fraction = 1.0f;
+    std::function<void(const graphics_memory_stats&)> _memory_budget_callback;
+    bool _over_memory_budget = false;
+
   protected:
     explicit graphics_device(std::unique_ptr<graphics_device_def> def, const graphics_config& config);
     virtual void wait_for_frame() = 0;
@@ -28,10 +39,15 @@ class graphics_device {
     virtual ~graphics_device() = default;
 
     [[nodiscard]] const graphics_device_def& def() const;
+    [[nodiscard]] const graphics_config& config() const;
     [[nodiscard]] int current_frame() const;
 
     void advance_frame();
 
+    // Checked once per frame. The callback runs when usage of any heap crosses the fraction of its budget, and again
+    // only after usage has dropped below it.
+    void set_memory_budget_callback(float fraction, std::function<void(const graphics_memory_stats&)> callback);
+
     // TODO: create_surface -> graphics_surface -> graphics_surface.create_swapchain() instead?
     virtual result::ptr<graphics_swapchain> create_swapchain(uint32_t width, uint32_t height) = 0;
     virtual result::ptr<graphics_shader> create_shader(std::unique_ptr<shader_binary> binary) = 0;
@@ -41,14 +57,47 @@ class graphics_device {
     virtual result::ptr<graphics_resource_set> create_resource_set(const graphics_resource_layout& layout,
                                                                    resource_set_ref set) = 0;
     virtual result::ptr<graphics_pipeline> create_pipeline(const graphics_pipeline_init& init) = 0;
-    virtual result::ptr<graphics_buffer> create_buffer(buffer_usage_flags usage, uint32_t size) = 0;
-    virtual result::ptr<graphics_image> create_image(uint32_t width, uint32_t height, graphics_image_format format) = 0;
+    virtual result::ptr<graphics_buffer> create_buffer(buffer_usage_flags usage, uint64_t size) = 0;
+    virtual result::ptr<graphics_image> create_image(const graphics_image_init& init) = 0;
+    result::ptr<graphics_image> create_image(uint32_t width, uint32_t height, graphics_image_format format);
+
+    // Uploads the initial data without waiting for it, and makes the resource immutable
+    result::ptr<graphics_buffer> create_buffer(buffer_usage_flags usage, const void* data, uint64_t size);
+    result::ptr<graphics_image> create_image(const graphics_image_init& init, const void* data, uint64_t size);
+    result::ptr<graphics_image> create_image(uint32_t width, uint32_t height, graphics_image_format format,
+                                             const void* data, uint64_t size);
+
+    // Whether images of the format can be created and sampled, which varies for compressed formats
+    [[nodiscard]] virtual bool image_format_supported(graphics_image_format format) = 0;
     virtual result::ptr<graphics_sampler> create_sampler(const graphics_sampler_init& init) = 0;
     virtual result::ptr<graphics_uniform_buffer> create_uniform_buffer(const shader_variable_type& type) = 0;
     virtual result::ptr<graphics_command_buffer> create_command_buffer() = 0;
 
-    virtual void submit_command_buffer(const graphics_command_buffer& command_buffer) = 0;
+    // Secondary command buffers, like primary ones, each record into their own memory, so separate threads can record
+    // them at the same time
+    virtual result::ptr<graphics_secondary_command_buffer> create_secondary_command_buffer() = 0;
+
+    virtual result::ptr<graphics_upload_batch> create_upload_batch() = 0;
+
+    // Bumps space from memory that is recycled once the current frame has completed, for data rewritten every frame
+    virtual graphics_transient_allocation allocate_transient(buffer_usage_flags usage, uint64_t size) = 0;
+    virtual result::ptr<graphics_geometry_arena> create_geometry_arena(buffer_usage_flags usage,
+                                                                       uint64_t block_size) = 0;
+
+    virtual result::ptr<graphics_semaphore> create_semaphore() = 0;
+
+    // Submits the command buffers together, in order, after uploading deferred writes. Transfers are waited for by the
+    // first submission. Completing the batch completes the frame, so there is one batch per frame.
+    virtual void submit(const std::vector<graphics_submission>& submissions) = 0;
+
+    // Submits a single command buffer that renders to the swapchain
+    void submit_command_buffer(const graphics_command_buffer& command_buffer);
     virtual void present(graphics_swapchain& swapchain) = 0;
+
+    [[nodiscard]] virtual graphics_memory_stats memory_stats() = 0;
+
+    [[nodiscard]] virtual bool transfer_complete(graphics_transfer_token token) = 0;
+    virtual void wait_for_transfer(graphics_transfer_token token) = 0;
 };
 
 #endif
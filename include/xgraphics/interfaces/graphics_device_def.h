@@ -9,6 +9,9 @@ struct graphics_device_def {
     device_type type;
     std::string name;
 
+    // Whether indirect draws can read their draw count from a buffer
+    bool draw_indirect_count = false;
+
     graphics_device_def() = default;
     graphics_device_def(const graphics_device_def&) = delete;
 };
@@ -0,0 +1,92 @@
+#ifndef WPEX_GRAPHICS_GEOMETRY_ARENA_H
+#define WPEX_GRAPHICS_GEOMETRY_ARENA_H
+
+#include "graphics_buffer.h"
+#include "graphics_transfer.h"
+#include <map>
+#include <memory>
+#include <result/result.h>
+#include <vector>
+
+// Identifies the arena, the allocation slot and the generation of the slot, so that handles to freed allocations or
+// from other arenas are rejected rather than aliasing a live allocation
+typedef uint64_t graphics_geometry_handle;
+
+// Where an allocation currently lives. Compaction moves allocations, so slices should not be kept across it.
+struct graphics_geometry_slice {
+    const graphics_buffer* buffer;
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct graphics_geometry_block {
+    std::unique_ptr<graphics_buffer> buffer;
+    std::map<uint64_t, uint64_t> free_ranges;
+};
+
+struct graphics_geometry_allocation {
+    uint32_t block;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t alignment;
+    uint32_t generation;
+    bool live;
+};
+
+struct graphics_geometry_copy {
+    const graphics_buffer* src;
+    uint64_t src_offset;
+    const graphics_buffer* dst;
+    uint64_t dst_offset;
+    uint64_t size;
+};
+
+// Packs many small vertex and index allocations into a few large buffers. Allocations are aligned to a multiple of
+// their stride or index size, so a slice offset divided by it can be passed as the vertex offset or index start.
+class graphics_geometry_arena {
+    uint32_t _id;
+    buffer_usage_flags _usage;
+    uint64_t _block_size;
+    std::vector<graphics_geometry_block> _blocks;
+    std::vector<graphics_geometry_allocation> _allocations;
+    std::vector<uint32_t> _free_indices;
+
+  protected:
+    explicit graphics_geometry_arena(buffer_usage_flags usage, uint64_t block_size);
+
+    virtual result::ptr<graphics_buffer> create_block(buffer_usage_flags usage, uint64_t size) = 0;
+
+    // Must not return until the GPU has finished the copies, and no longer reads from the source buffers
+    virtual void copy(const std::vector<graphics_geometry_copy>& copies) = 0;
+
+  public:
+    graphics_geometry_arena(const graphics_geometry_arena&) = delete;
+    virtual ~graphics_geometry_arena() = default;
+
+    [[nodiscard]] buffer_usage_flags usage() const;
+    [[nodiscard]] uint64_t block_size() const;
+    [[nodiscard]] uint32_t block_count() const;
+
+    result::val<graphics_geometry_handle> allocate(uint64_t size, uint32_t alignment);
+
+    // Handles that were freed or belong to another arena throw, including a second free of the same handle
+    void free(graphics_geometry_handle handle);
+    [[nodiscard]] graphics_geometry_slice slice(graphics_geometry_handle handle) const;
+
+    // Throws if the data is larger than the allocation
+    void write(graphics_geometry_handle handle, const void* data, uint64_t size);
+    graphics_transfer_token write_async(graphics_geometry_handle handle, const void* data, uint64_t size);
+
+    // Moves every live allocation into as few blocks as possible, and releases the old ones. Returns the number of
+    // blocks left, and keeps the current blocks if a new one cannot be created.
+    result::val<uint32_t> compact();
+
+  private:
+    [[nodiscard]] graphics_geometry_handle handle(uint32_t index) const;
+    [[nodiscard]] uint32_t index(graphics_geometry_handle handle) const;
+
+    static bool allocate_from(graphics_geometry_block& block, uint64_t size, uint32_t alignment, uint64_t& offset);
+    static void release_to(graphics_geometry_block& block, uint64_t offset, uint64_t size);
+};
+
+#endif
@@ -1,30 +1,138 @@
 #ifndef WPEX_GRAPHICS_IMAGE_H
 #define WPEX_GRAPHICS_IMAGE_H
 
+#include "graphics_readback.h"
+#include "graphics_transfer.h"
 #include <cstdint>
+#include <memory>
 
 enum class graphics_image_format {
     rgba_8_srgb,
     rgba_8_unorm,
+    bc1_srgb,
+    bc1_unorm,
+    bc3_srgb,
+    bc3_unorm,
+    bc4_unorm,
+    bc5_unorm,
+    bc7_srgb,
+    bc7_unorm,
+    etc2_rgba_8_srgb,
+    etc2_rgba_8_unorm,
+    astc_4x4_srgb,
+    astc_4x4_unorm,
+};
+
+enum class graphics_image_type {
+    image_2d,
+    image_2d_array,
+    cube,
+    image_3d,
+};
+
+// Texels are stored in blocks, which are a single texel for uncompressed formats
+struct graphics_image_format_info {
+    uint32_t block_width;
+    uint32_t block_height;
+    uint32_t block_size;
+};
+
+struct graphics_image_init {
+    uint32_t width;
+    uint32_t height;
+    graphics_image_format format;
+
+    // Cube images always have 6 layers, one per face in +X, -X, +Y, -Y, +Z, -Z order. Layers are only used by array
+    // images, and depth only by 3D images.
+    graphics_image_type type = graphics_image_type::image_2d;
+    uint32_t layers = 1;
+    uint32_t depth = 1;
+
+    // Allocates the full mip chain, which is generated on the GPU from the top level whenever the image is written.
+    // Otherwise mip_levels are allocated, and each is written separately.
+    bool mipmaps = false;
+    uint32_t mip_levels = 1;
 };
 
 class graphics_image {
     uint32_t _width;
     uint32_t _height;
+    uint32_t _depth;
+    uint32_t _layers;
     graphics_image_format _format;
+    graphics_image_type _type;
+    uint32_t _mip_levels;
+    bool _mipmaps;
+    bool _immutable = false;
 
   protected:
-    explicit graphics_image(uint32_t width, uint32_t height, graphics_image_format format);
+    explicit graphics_image(const graphics_image_init& init);
+
+    // Throws if the region is not within the level, or not aligned to the blocks of the format
+    void check_region(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t mip_level,
+                      uint32_t layer) const;
 
   public:
     graphics_image(const graphics_image&) = delete;
     virtual ~graphics_image() = default;
 
-    virtual void write(const void* data, uint32_t size) = 0;
+    // Writes the top level of every layer, one after another
+    virtual void write(const void* data, uint64_t size) = 0;
+    virtual graphics_transfer_token write_async(const void* data, uint64_t size) = 0;
+
+    // Writes a single mip level of every layer, in the same layout as it is stored in, such as a pre-compressed level
+    // of a file
+    virtual void write_level(uint32_t mip_level, const void* data, uint64_t size) = 0;
+    virtual graphics_transfer_token write_level_async(uint32_t mip_level, const void* data, uint64_t size) = 0;
+
+    // Writes a single mip level of one layer, keeping the other layers
+    virtual void write_layer(uint32_t layer, uint32_t mip_level, const void* data, uint64_t size) = 0;
+    virtual graphics_transfer_token write_layer_async(uint32_t layer, uint32_t mip_level, const void* data,
+                                                      uint64_t size) = 0;
+
+    // Writes a rectangle of a single level, keeping the rest of its contents. Rows of the data are row_pitch bytes
+    // apart, or tightly packed when it is 0. Compressed regions must be aligned to blocks, except at the level edges.
+    // The layer of a 3D image is the depth slice of the level that is written.
+    // Regions are uploaded with the next command buffer submission, and all of them are copied together.
+    virtual void write_region(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t mip_level,
+                              uint32_t layer, const void* data, uint64_t row_pitch = 0) = 0;
+
+    // Reads a single mip level of one layer, tightly packed in the same layout that it is written in
+    virtual std::unique_ptr<graphics_readback> read_async(uint32_t mip_level, uint32_t layer) = 0;
 
     [[nodiscard]] uint32_t width() const;
     [[nodiscard]] uint32_t height() const;
+    [[nodiscard]] uint32_t depth() const;
+    [[nodiscard]] uint32_t layers() const;
     [[nodiscard]] graphics_image_format format() const;
+    [[nodiscard]] graphics_image_type type() const;
+    [[nodiscard]] uint32_t mip_levels() const;
+    [[nodiscard]] bool generates_mipmaps() const;
+
+    [[nodiscard]] uint32_t level_width(uint32_t mip_level) const;
+    [[nodiscard]] uint32_t level_height(uint32_t mip_level) const;
+    [[nodiscard]] uint32_t level_depth(uint32_t mip_level) const;
+    [[nodiscard]] uint64_t level_row_pitch(uint32_t mip_level) const;
+
+    // The size of a single layer of the level, including every depth slice of a 3D image
+    [[nodiscard]] uint64_t level_size(uint32_t mip_level) const;
+
+    // Packed rows of a region are rows of blocks
+    [[nodiscard]] uint64_t region_row_pitch(uint32_t width) const;
+    [[nodiscard]] uint32_t region_rows(uint32_t height) const;
+
+    // Immutable images reject any further writes
+    [[nodiscard]] bool immutable() const;
+    void make_immutable();
+
+    static graphics_image_format_info format_info(graphics_image_format format);
+    static bool compressed(graphics_image_format format);
+
+    // Levels in a full mip chain, down to 1x1x1
+    static uint32_t mip_level_count(uint32_t width, uint32_t height, uint32_t depth = 1);
+
+    // Checks that the size of the image fits its type
+    static bool valid(const graphics_image_init& init);
 };
 
 #endif
@@ -0,0 +1,38 @@
+#ifndef WPEX_GRAPHICS_MEMORY_H
+#define WPEX_GRAPHICS_MEMORY_H
+
+#include <cstdint>
+#include <vector>
+
+struct graphics_memory_heap {
+    uint64_t size = 0;
+    bool device_local = false;
+
+    // Usage and budget cover the whole process, and come from the driver when it can report them
+    uint64_t usage = 0;
+    uint64_t budget = 0;
+
+    // Memory allocated by this device
+    uint32_t allocation_count = 0;
+    uint64_t allocation_bytes = 0;
+};
+
+struct graphics_memory_stats {
+    std::vector<graphics_memory_heap> heaps;
+    uint32_t allocation_count = 0;
+
+    // Bytes allocated by this device, by the kind of resource they back
+    uint64_t vertex_buffer_bytes = 0;
+    uint64_t index_buffer_bytes = 0;
+    uint64_t uniform_buffer_bytes = 0;
+    uint64_t indirect_buffer_bytes = 0;
+
+    // Buffers created without any usage
+    uint64_t other_buffer_bytes = 0;
+    uint64_t image_bytes = 0;
+    uint64_t staging_bytes = 0;
+    uint64_t readback_bytes = 0;
+    uint64_t depth_bytes = 0;
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef WPEX_GRAPHICS_READBACK_H
+#define WPEX_GRAPHICS_READBACK_H
+
+#include <cstdint>
+
+// Data copied back from the GPU without blocking, which becomes readable once the copy has completed. Copies are
+// ordered after every write to the resource that was submitted before the read.
+class graphics_readback {
+    uint64_t _size;
+
+  protected:
+    explicit graphics_readback(uint64_t size);
+
+  public:
+    graphics_readback(const graphics_readback&) = delete;
+    virtual ~graphics_readback() = default;
+
+    [[nodiscard]] uint64_t size() const;
+
+    [[nodiscard]] virtual bool ready() = 0;
+    virtual void wait() = 0;
+
+    // Waits for the copy if it has not completed yet
+    [[nodiscard]] virtual const void* data() = 0;
+};
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef WPEX_GRAPHICS_RESOURCE_SET_H
 #define WPEX_GRAPHICS_RESOURCE_SET_H
 
+#include "graphics_buffer.h"
 #include "graphics_image.h"
 #include "graphics_resource_layout.h"
 #include "graphics_sampler.h"
@@ -22,6 +23,11 @@ class graphics_resource_set {
 
     // TODO: Need to make sure buffer type matches uniform type
     virtual void bind_uniform_buffer(resource_binding_ref binding, const graphics_uniform_buffer& buffer) = 0;
+
+    // Binds a range of a buffer with uniform usage for the current frame only, such as a transient allocation. Must be
+    // called before the set is bound for the frame.
+    virtual void bind_uniform_buffer(resource_binding_ref binding, const graphics_buffer& buffer, uint64_t offset,
+                                     uint64_t size) = 0;
     virtual void bind_sampled_image(resource_binding_ref binding, const graphics_image& image,
                                     const graphics_sampler& sampler) = 0;
 };
@@ -24,6 +24,11 @@ struct graphics_sampler_init {
     } address_mode;
     bool enable_anisotropy = true;
     float max_anisotropy = 1.0f;
+
+    // Range of mip levels that may be sampled, and an offset added to the level the hardware selects
+    float min_lod = 0.0f;
+    float max_lod = 1000.0f;
+    float lod_bias = 0.0f;
 };
 
 class graphics_sampler {
@@ -0,0 +1,17 @@
+#ifndef WPEX_GRAPHICS_SECONDARY_COMMAND_BUFFER_H
+#define WPEX_GRAPHICS_SECONDARY_COMMAND_BUFFER_H
+
+#include "graphics_command_recorder.h"
+#include "graphics_render_pass.h"
+
+// Records draws of a render pass that a primary command buffer executes inside it. Every secondary command buffer
+// records independently, so each one can be recorded on its own thread.
+class graphics_secondary_command_buffer : public graphics_command_recorder {
+  public:
+    explicit graphics_secondary_command_buffer() = default;
+
+    virtual void begin(const graphics_render_pass& render_pass) = 0;
+    virtual void end() = 0;
+};
+
+#endif
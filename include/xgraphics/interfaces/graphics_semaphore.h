@@ -0,0 +1,28 @@
+#ifndef WPEX_GRAPHICS_SEMAPHORE_H
+#define WPEX_GRAPHICS_SEMAPHORE_H
+
+#include "graphics_command_buffer.h"
+#include <vector>
+
+// Orders submissions on the GPU. Every signal must be waited on by exactly one later submission before the semaphore
+// is signaled again, which lets the same semaphores be used every frame.
+class graphics_semaphore {
+  protected:
+    explicit graphics_semaphore() = default;
+
+  public:
+    graphics_semaphore(const graphics_semaphore&) = delete;
+    virtual ~graphics_semaphore() = default;
+};
+
+struct graphics_submission {
+    const graphics_command_buffer* command_buffer;
+    std::vector<const graphics_semaphore*> wait_semaphores;
+    std::vector<const graphics_semaphore*> signal_semaphores;
+
+    // Waits for the swapchain image before writing to it, and signals presenting it. Only one submission of a frame
+    // that presents can set it, and offscreen work leaves it unset.
+    bool swapchain = false;
+};
+
+#endif
@@ -2,6 +2,16 @@
 #define WPEX_GRAPHICS_SWAPCHAIN_H
 
 #include <cstdint>
+#include <vector>
+
+// FIFO waits for vertical blank and is always supported. Relaxed FIFO presents a late image immediately, mailbox
+// replaces the queued image instead of blocking, and immediate never waits, which can tear.
+enum class graphics_present_mode {
+    fifo,
+    fifo_relaxed,
+    mailbox,
+    immediate,
+};
 
 class graphics_swapchain {
     uint32_t _width;
@@ -17,8 +27,16 @@ class graphics_swapchain {
     [[nodiscard]] uint32_t width() const;
     [[nodiscard]] uint32_t height() const;
 
+    // What the swapchain was actually created with, which can differ from the config
+    [[nodiscard]] virtual graphics_present_mode present_mode() const = 0;
+    [[nodiscard]] virtual uint32_t image_count() const = 0;
+
     virtual void swap() = 0;
     virtual void resize(uint32_t width, uint32_t height);
+
+    // The first preferred mode that is supported, or FIFO when there is none
+    static graphics_present_mode choose_present_mode(const std::vector<graphics_present_mode>& preferred,
+                                                     const std::vector<graphics_present_mode>& supported);
 };
 
 #endif
@@ -0,0 +1,11 @@
+#ifndef WPEX_GRAPHICS_TRANSFER_H
+#define WPEX_GRAPHICS_TRANSFER_H
+
+#include <cstdint>
+
+// Identifies a transfer submitted to the GPU. A default constructed token refers to no work and is always complete.
+struct graphics_transfer_token {
+    uint64_t value = 0;
+};
+
+#endif
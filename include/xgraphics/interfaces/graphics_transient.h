@@ -0,0 +1,15 @@
+#ifndef WPEX_GRAPHICS_TRANSIENT_H
+#define WPEX_GRAPHICS_TRANSIENT_H
+
+#include "graphics_buffer.h"
+
+// Space in host visible memory that is only valid for the current frame. The data is written directly through the
+// pointer, and the buffer range can be bound as vertex, index or uniform data.
+struct graphics_transient_allocation {
+    const graphics_buffer* buffer;
+    uint64_t offset;
+    uint64_t size;
+    void* data;
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef WPEX_GRAPHICS_UPLOAD_BATCH_H
+#define WPEX_GRAPHICS_UPLOAD_BATCH_H
+
+#include "graphics_buffer.h"
+#include "graphics_image.h"
+#include "graphics_transfer.h"
+#include <chrono>
+#include <cstdint>
+
+// Collects buffer and image writes and submits them to the GPU together. Data is copied when it is written, so it
+// does not have to outlive the call.
+class graphics_upload_batch {
+    uint64_t _bytes = 0;
+    std::chrono::steady_clock::time_point _start;
+    std::chrono::steady_clock::duration _duration = {};
+    graphics_transfer_token _token;
+
+  protected:
+    explicit graphics_upload_batch() = default;
+
+    virtual void record_write(graphics_buffer& buffer, const void* data, uint64_t size) = 0;
+    virtual void record_write(graphics_image& image, const void* data, uint64_t size) = 0;
+    virtual graphics_transfer_token submit_writes() = 0;
+    virtual void wait_for_writes(graphics_transfer_token token) = 0;
+
+  public:
+    graphics_upload_batch(const graphics_upload_batch&) = delete;
+    virtual ~graphics_upload_batch() = default;
+
+    void write(graphics_buffer& buffer, const void* data, uint64_t size);
+    void write(graphics_image& image, const void* data, uint64_t size);
+    graphics_transfer_token submit();
+    void wait();
+
+    // Throughput from the first write until wait() returned
+    [[nodiscard]] uint64_t bytes() const;
+    [[nodiscard]] double bytes_per_second() const;
+};
+
+#endif
@@ -8,14 +8,21 @@
 class metal_buffer : public graphics_buffer {
     id<MTLBuffer> _buffer;
 
-    metal_buffer(buffer_usage_flags usage, uint32_t size, id<MTLBuffer> buffer);
+    metal_buffer(buffer_usage_flags usage, uint64_t size, id<MTLBuffer> buffer);
 
   public:
-    static result::ptr<graphics_buffer> create(buffer_usage_flags usage, uint32_t size, id<MTLDevice> device);
+    static result::ptr<graphics_buffer> create(buffer_usage_flags usage, uint64_t size, id<MTLDevice> device);
 
     [[nodiscard]] id<MTLBuffer> buffer() const;
 
-    void write(const void* data, uint32_t size) override;
+    using graphics_buffer::read_async;
+    using graphics_buffer::write;
+    using graphics_buffer::write_async;
+
+    void write(uint64_t offset, const void* data, uint64_t size) override;
+    graphics_transfer_token write_async(uint64_t offset, const void* data, uint64_t size) override;
+    void write_deferred(uint64_t offset, const void* data, uint64_t size) override;
+    std::unique_ptr<graphics_readback> read_async(uint64_t offset, uint64_t size) override;
 };
 
 #endif
@@ -1,9 +1,10 @@
 #include "metal_buffer.h"
+#include "metal_readback.h"
 
-metal_buffer::metal_buffer(buffer_usage_flags usage, uint32_t size, id<MTLBuffer> buffer)
+metal_buffer::metal_buffer(buffer_usage_flags usage, uint64_t size, id<MTLBuffer> buffer)
     : graphics_buffer(usage, size), _buffer(buffer) { }
 
-result::ptr<graphics_buffer> metal_buffer::create(buffer_usage_flags usage, uint32_t size, id<MTLDevice> device) {
+result::ptr<graphics_buffer> metal_buffer::create(buffer_usage_flags usage, uint64_t size, id<MTLDevice> device) {
     id<MTLBuffer> buffer = [device newBufferWithLength:size options:MTLResourceStorageModeShared];
     return result::ok(new metal_buffer(usage, size, buffer));
 }
@@ -12,6 +13,28 @@ id<MTLBuffer> metal_buffer::buffer() const {
     return _buffer;
 }
 
-void metal_buffer::write(const void* data, uint32_t size) {
-    memcpy(_buffer.contents, data, size);
+void metal_buffer::write(uint64_t offset, const void* data, uint64_t size) {
+    if (immutable()) throw std::runtime_error("Cannot write to an immutable buffer");
+
+    memcpy((uint8_t*) _buffer.contents + offset, data, size);
+}
+
+graphics_transfer_token metal_buffer::write_async(uint64_t offset, const void* data, uint64_t size) {
+    // Shared storage is written directly, so there is never any pending transfer
+    write(offset, data, size);
+    return {};
+}
+
+void metal_buffer::write_deferred(uint64_t offset, const void* data, uint64_t size) {
+    write(offset, data, size);
+}
+
+std::unique_ptr<graphics_readback> metal_buffer::read_async(uint64_t offset, uint64_t size) {
+    if (offset > this->size() || size > this->size() - offset) throw std::runtime_error("Buffer read is out of range");
+
+    // Only the host writes shared buffers, so their contents can be copied right away
+    id<MTLBuffer> readback = [_buffer.device newBufferWithBytes:(const uint8_t*) _buffer.contents + offset
+                                                         length:size
+                                                        options:MTLResourceStorageModeShared];
+    return std::make_unique<metal_readback>(readback, size, nil);
 }
@@ -13,9 +13,18 @@ class metal_command_buffer : public graphics_command_buffer {
     id<MTLRenderCommandEncoder> _render_command_encoder = nullptr;
     const metal_pipeline* _current_pipeline = nullptr;
 
+    // Metal takes the index buffer with every draw
+    id<MTLBuffer> _index_buffer = nullptr;
+    uint64_t _index_offset = 0;
+    MTLIndexType _index_type = MTLIndexTypeUInt16;
+    graphics_command_stats _stats;
+
     explicit metal_command_buffer(id<MTLCommandQueue> command_queue);
 
   public:
+    using graphics_command_buffer::draw;
+    using graphics_command_buffer::draw_indexed;
+
     static result::ptr<graphics_command_buffer> create(id<MTLCommandQueue> command_queue);
 
     [[nodiscard]] id<MTLCommandBuffer> command_buffer() const;
@@ -23,14 +32,24 @@ class metal_command_buffer : public graphics_command_buffer {
     void begin() override;
     void end() override;
     void begin_render_pass(const graphics_render_pass& render_pass) override;
+    void begin_render_pass(const graphics_render_pass& render_pass,
+                           const std::vector<const graphics_secondary_command_buffer*>& command_buffers) override;
     void end_render_pass() override;
     void bind_pipeline(const graphics_pipeline& pipeline) override;
-    void bind_vertex_buffer(const graphics_buffer& buffer, uint32_t offset, int index) override;
+    void bind_vertex_buffers(uint32_t first_index, std::span<const graphics_vertex_buffer_binding> buffers) override;
+    void bind_index_buffer(const graphics_buffer& buffer, uint64_t offset, index_type type) override;
     void bind_resource_set(const graphics_resource_set& resource_set) override;
     void draw(uint32_t vertex_start, uint32_t vertex_count, uint32_t instance_start, uint32_t instance_count) override;
-    void draw_indexed(const graphics_buffer& index_buffer, uint32_t index_offset, index_type type, uint32_t index_start,
-                      uint32_t index_count, uint32_t vertex_offset, uint32_t instance_start,
+    void draw_indexed(uint32_t index_start, uint32_t index_count, uint32_t vertex_offset, uint32_t instance_start,
                       uint32_t instance_count) override;
+    void draw_indirect(const graphics_buffer& buffer, uint64_t offset, uint32_t draw_count) override;
+    void draw_indexed_indirect(const graphics_buffer& buffer, uint64_t offset, uint32_t draw_count) override;
+    void draw_indirect_count(const graphics_buffer& buffer, uint64_t offset, const graphics_buffer& count_buffer,
+                             uint64_t count_offset, uint32_t max_draw_count) override;
+    void draw_indexed_indirect_count(const graphics_buffer& buffer, uint64_t offset,
+                                     const graphics_buffer& count_buffer, uint64_t count_offset,
+                                     uint32_t max_draw_count) override;
+    [[nodiscard]] graphics_command_stats stats() const override;
 };
 
 #endif
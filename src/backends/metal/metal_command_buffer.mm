@@ -2,6 +2,7 @@
 #import "metal_buffer.h"
 #import "metal_render_pass.h"
 #import "metal_resource_set.h"
+#import "metal_secondary_command_buffer.h"
 
 metal_command_buffer::metal_command_buffer(id<MTLCommandQueue> command_queue) : _command_queue(command_queue) { }
 
@@ -15,6 +16,7 @@ id<MTLCommandBuffer> metal_command_buffer::command_buffer() const {
 
 void metal_command_buffer::begin() {
     _command_buffer = [_command_queue commandBuffer];
+    _stats = {};
 }
 
 void metal_command_buffer::end() {
@@ -33,6 +35,14 @@ void metal_command_buffer::begin_render_pass(const graphics_render_pass& render_
     _render_command_encoder = [_command_buffer renderCommandEncoderWithDescriptor:descriptor];
 }
 
+void metal_command_buffer::begin_render_pass(
+    const graphics_render_pass& render_pass,
+    const std::vector<const graphics_secondary_command_buffer*>& command_buffers) {
+    begin_render_pass(render_pass);
+    for (const auto* secondary : command_buffers)
+        ((const metal_secondary_command_buffer*) secondary)->execute(*this);
+}
+
 void metal_command_buffer::end_render_pass() {
     [_render_command_encoder endEncoding];
     [_render_command_encoder release];
@@ -45,12 +55,41 @@ void metal_command_buffer::bind_pipeline(const graphics_pipeline& pipeline) {
     [_render_command_encoder setDepthStencilState:native_pipeline.depth_stencil_state()];
     [_render_command_encoder setCullMode:MTLCullModeNone];
     _current_pipeline = &native_pipeline;
+    _stats.pipeline_binds++;
+}
+
+void metal_command_buffer::bind_vertex_buffers(uint32_t first_index,
+                                               std::span<const graphics_vertex_buffer_binding> buffers) {
+    std::vector<id<MTLBuffer>> native_buffers;
+    std::vector<NSUInteger> offsets;
+    for (const auto& binding : buffers) {
+        native_buffers.push_back(((const metal_buffer*) binding.buffer)->buffer());
+        offsets.push_back(binding.offset);
+    }
+
+    auto buffer_index = first_index + _current_pipeline->vertex_buffer_index_offset();
+    [_render_command_encoder setVertexBuffers:native_buffers.data()
+                                      offsets:offsets.data()
+                                    withRange:NSMakeRange(buffer_index, buffers.size())];
+    _stats.vertex_buffer_binds += buffers.size();
 }
 
-void metal_command_buffer::bind_vertex_buffer(const graphics_buffer& buffer, uint32_t offset, int index) {
+void metal_command_buffer::bind_index_buffer(const graphics_buffer& buffer, uint64_t offset, index_type type) {
     const auto& native_buffer = (const metal_buffer&) buffer;
-    auto buffer_index = index + _current_pipeline->vertex_buffer_index_offset();
-    [_render_command_encoder setVertexBuffer:native_buffer.buffer() offset:offset atIndex:buffer_index];
+    switch (type) {
+        case index_type::uint_16:
+            _index_type = MTLIndexTypeUInt16;
+            break;
+        case index_type::uint_32:
+            _index_type = MTLIndexTypeUInt32;
+            break;
+        default:
+            throw std::runtime_error("Unsupported index type");
+    }
+
+    _index_buffer = native_buffer.buffer();
+    _index_offset = offset;
+    _stats.index_buffer_binds++;
 }
 
 void metal_command_buffer::bind_resource_set(const graphics_resource_set& resource_set) {
@@ -75,6 +114,7 @@ void metal_command_buffer::bind_resource_set(const graphics_resource_set& resour
                                         usage:MTLResourceUsageRead
                                        stages:MTLRenderStageFragment];
     }
+    _stats.resource_set_binds++;
 }
 
 void metal_command_buffer::draw(uint32_t vertex_start, uint32_t vertex_count, uint32_t instance_start,
@@ -84,35 +124,60 @@ void metal_command_buffer::draw(uint32_t vertex_start, uint32_t vertex_count, ui
                                 vertexCount:vertex_count
                               instanceCount:instance_count
                                baseInstance:instance_start];
+    _stats.draws++;
 }
 
-void metal_command_buffer::draw_indexed(const graphics_buffer& index_buffer, uint32_t index_offset, index_type type,
-                                        uint32_t index_start, uint32_t index_count, uint32_t vertex_offset,
+void metal_command_buffer::draw_indexed(uint32_t index_start, uint32_t index_count, uint32_t vertex_offset,
                                         uint32_t instance_start, uint32_t instance_count) {
-    const auto& native_buffer = (const metal_buffer&) index_buffer;
-    MTLIndexType index_type;
-    int type_size;
-
-    switch (type) {
-        case index_type::uint_16:
-            index_type = MTLIndexTypeUInt16;
-            type_size = 2;
-            break;
-        case index_type::uint_32:
-            index_type = MTLIndexTypeUInt32;
-            type_size = 4;
-            break;
-        default:
-            throw std::runtime_error("Unsupported index type");
-    }
-
-    uint32_t final_index_offset = index_offset + index_start * type_size;
+    uint64_t type_size = _index_type == MTLIndexTypeUInt16 ? 2 : 4;
+    uint64_t final_index_offset = _index_offset + index_start * type_size;
     [_render_command_encoder drawIndexedPrimitives:MTLPrimitiveTypeTriangle
                                         indexCount:index_count
-                                         indexType:index_type
-                                       indexBuffer:native_buffer.buffer()
+                                         indexType:_index_type
+                                       indexBuffer:_index_buffer
                                  indexBufferOffset:final_index_offset
                                      instanceCount:instance_count
                                         baseVertex:vertex_offset
                                       baseInstance:instance_start];
+    _stats.draws++;
+}
+
+void metal_command_buffer::draw_indirect(const graphics_buffer& buffer, uint64_t offset, uint32_t draw_count) {
+    const auto& native_buffer = (const metal_buffer&) buffer;
+    for (uint32_t i = 0; i < draw_count; i++) {
+        [_render_command_encoder drawPrimitives:MTLPrimitiveTypeTriangle
+                                 indirectBuffer:native_buffer.buffer()
+                           indirectBufferOffset:offset + i * sizeof(graphics_draw_indirect_command)];
+    }
+    _stats.draws++;
+}
+
+void metal_command_buffer::draw_indexed_indirect(const graphics_buffer& buffer, uint64_t offset,
+                                                 uint32_t draw_count) {
+    const auto& native_buffer = (const metal_buffer&) buffer;
+    for (uint32_t i = 0; i < draw_count; i++) {
+        [_render_command_encoder drawIndexedPrimitives:MTLPrimitiveTypeTriangle
+                                             indexType:_index_type
+                                           indexBuffer:_index_buffer
+                                     indexBufferOffset:_index_offset
+                                        indirectBuffer:native_buffer.buffer()
+                                  indirectBufferOffset:offset + i * sizeof(graphics_draw_indexed_indirect_command)];
+    }
+    _stats.draws++;
+}
+
+void metal_command_buffer::draw_indirect_count(const graphics_buffer& buffer, uint64_t offset,
+                                               const graphics_buffer& count_buffer, uint64_t count_offset,
+                                               uint32_t max_draw_count) {
+    throw std::runtime_error("Indirect draw counts are not supported");
+}
+
+void metal_command_buffer::draw_indexed_indirect_count(const graphics_buffer& buffer, uint64_t offset,
+                                                       const graphics_buffer& count_buffer, uint64_t count_offset,
+                                                       uint32_t max_draw_count) {
+    throw std::runtime_error("Indirect draw counts are not supported");
+}
+
+graphics_command_stats metal_command_buffer::stats() const {
+    return _stats;
 }
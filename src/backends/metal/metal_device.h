@@ -2,6 +2,7 @@
 #define XGRAPHICS_METAL_DEVICE_H
 
 #import "metal_sync_context.h"
+#import "metal_transient_allocator.h"
 #import <MetalKit/MetalKit.h>
 #import <result/result.h>
 #import <xgraphics/xgraphics.h>
@@ -12,11 +13,13 @@ class metal_device : public graphics_device {
     id<MTLCommandBuffer> _command_buffer_to_present = nullptr;
     CAMetalLayer* _layer;
     std::unique_ptr<metal_sync_context> _sync_context;
+    std::unique_ptr<metal_transient_allocator> _transient_allocator;
 
     // TODO: Make these constructors private
     explicit metal_device(std::unique_ptr<graphics_device_def> def, const graphics_config& config, id<MTLDevice> device,
                           id<MTLCommandQueue> command_queue, CAMetalLayer* layer,
-                          std::unique_ptr<metal_sync_context> sync_context);
+                          std::unique_ptr<metal_sync_context> sync_context,
+                          std::unique_ptr<metal_transient_allocator> transient_allocator);
 
   protected:
     void wait_for_frame() override;
@@ -35,13 +38,27 @@ class metal_device : public graphics_device {
                                                            resource_set_ref ref) override;
     result::ptr<graphics_pipeline> create_pipeline(const graphics_pipeline_init& init) override;
     result::ptr<graphics_command_buffer> create_command_buffer() override;
-    result::ptr<graphics_buffer> create_buffer(buffer_usage_flags usage, uint32_t size) override;
-    result::ptr<graphics_image> create_image(uint32_t width, uint32_t height, graphics_image_format format) override;
+    result::ptr<graphics_secondary_command_buffer> create_secondary_command_buffer() override;
+    result::ptr<graphics_upload_batch> create_upload_batch() override;
+    graphics_transient_allocation allocate_transient(buffer_usage_flags usage, uint64_t size) override;
+    result::ptr<graphics_geometry_arena> create_geometry_arena(buffer_usage_flags usage, uint64_t block_size) override;
+    using graphics_device::create_buffer;
+    using graphics_device::create_image;
+
+    result::ptr<graphics_buffer> create_buffer(buffer_usage_flags usage, uint64_t size) override;
+    result::ptr<graphics_image> create_image(const graphics_image_init& init) override;
+    bool image_format_supported(graphics_image_format format) override;
     result::ptr<graphics_sampler> create_sampler(const graphics_sampler_init& init) override;
     result::ptr<graphics_uniform_buffer> create_uniform_buffer(const shader_variable_type& type) override;
 
-    void submit_command_buffer(const graphics_command_buffer& command_buffer) override;
+    result::ptr<graphics_semaphore> create_semaphore() override;
+    void submit(const std::vector<graphics_submission>& submissions) override;
     void present(graphics_swapchain& swapchain) override;
+
+    graphics_memory_stats memory_stats() override;
+
+    bool transfer_complete(graphics_transfer_token token) override;
+    void wait_for_transfer(graphics_transfer_token token) override;
 };
 
 #endif
@@ -3,23 +3,29 @@
 #import "metal_buffer.h"
 #import "metal_command_buffer.h"
 #import "metal_device_def.h"
+#import "metal_geometry_arena.h"
 #import "metal_image.h"
 #import "metal_pipeline.h"
 #import "metal_render_pass.h"
 #import "metal_resource_layout.h"
 #import "metal_resource_set.h"
 #import "metal_sampler.h"
+#import "metal_secondary_command_buffer.h"
+#import "metal_semaphore.h"
 #import "metal_shader.h"
 #import "metal_uniform_buffer.h"
+#import "metal_upload_batch.h"
 
 metal_device::metal_device(std::unique_ptr<graphics_device_def> def, const graphics_config& config,
                            id<MTLDevice> device, id<MTLCommandQueue> command_queue, CAMetalLayer* layer,
-                           std::unique_ptr<metal_sync_context> sync_context)
+                           std::unique_ptr<metal_sync_context> sync_context,
+                           std::unique_ptr<metal_transient_allocator> transient_allocator)
     : graphics_device(std::move(def), config),
       _device(device),
       _command_queue(command_queue),
       _layer(layer),
-      _sync_context(std::move(sync_context)) { }
+      _sync_context(std::move(sync_context)),
+      _transient_allocator(std::move(transient_allocator)) { }
 
 void metal_device::wait_for_frame() {
     dispatch_semaphore_wait(_sync_context->semaphore(), DISPATCH_TIME_FOREVER);
@@ -27,6 +33,7 @@ void metal_device::wait_for_frame() {
 
 void metal_device::frame_changed(int current_frame) {
     _sync_context->set_current_frame(current_frame);
+    _transient_allocator->reset(current_frame);
 }
 
 result::ptr<graphics_device> metal_device::create(std::unique_ptr<graphics_device_def> def,
@@ -35,12 +42,14 @@ result::ptr<graphics_device> metal_device::create(std::unique_ptr<graphics_devic
     id<MTLCommandQueue> command_queue = [native_def.metal_device newCommandQueue];
 
     auto sync_context = GET_OR_FORWARD(metal_sync_context::create(config));
+    auto transient_allocator =
+        GET_OR_FORWARD(metal_transient_allocator::create(native_def.metal_device, config.frames_in_flight));
     return result::ok(new metal_device(std::move(def), config, native_def.metal_device, command_queue, layer,
-                                       std::move(sync_context)));
+                                       std::move(sync_context), std::move(transient_allocator)));
 }
 
 result::ptr<graphics_swapchain> metal_device::create_swapchain(uint32_t width, uint32_t height) {
-    return metal_swapchain::create(_device, _layer, width, height);
+    return metal_swapchain::create(_device, _layer, width, height, config());
 }
 
 result::ptr<graphics_shader> metal_device::create_shader(std::unique_ptr<shader_binary> binary) {
@@ -71,12 +80,33 @@ result::ptr<graphics_command_buffer> metal_device::create_command_buffer() {
     return metal_command_buffer::create(_command_queue);
 }
 
-result::ptr<graphics_buffer> metal_device::create_buffer(buffer_usage_flags usage, uint32_t size) {
+result::ptr<graphics_secondary_command_buffer> metal_device::create_secondary_command_buffer() {
+    return metal_secondary_command_buffer::create();
+}
+
+result::ptr<graphics_upload_batch> metal_device::create_upload_batch() {
+    return metal_upload_batch::create();
+}
+
+graphics_transient_allocation metal_device::allocate_transient(buffer_usage_flags usage, uint64_t size) {
+    return _transient_allocator->allocate(usage, size);
+}
+
+result::ptr<graphics_geometry_arena> metal_device::create_geometry_arena(buffer_usage_flags usage,
+                                                                         uint64_t block_size) {
+    return metal_geometry_arena::create(usage, block_size, _device);
+}
+
+result::ptr<graphics_buffer> metal_device::create_buffer(buffer_usage_flags usage, uint64_t size) {
     return metal_buffer::create(usage, size, _device);
 }
 
-result::ptr<graphics_image> metal_device::create_image(uint32_t width, uint32_t height, graphics_image_format format) {
-    return metal_image::create(width, height, format, _device);
+result::ptr<graphics_image> metal_device::create_image(const graphics_image_init& init) {
+    return metal_image::create(init, _device, _command_queue);
+}
+
+bool metal_device::image_format_supported(graphics_image_format format) {
+    return metal_image::format_supported(_device, format);
 }
 
 result::ptr<graphics_sampler> metal_device::create_sampler(const graphics_sampler_init& init) {
@@ -87,9 +117,19 @@ result::ptr<graphics_uniform_buffer> metal_device::create_uniform_buffer(const s
     return metal_uniform_buffer::create(type, _device, *_sync_context);
 }
 
-void metal_device::submit_command_buffer(const graphics_command_buffer& command_buffer) {
-    const auto& native_command_buffer = (const metal_command_buffer&) command_buffer;
-    _command_buffer_to_present = native_command_buffer.command_buffer();
+result::ptr<graphics_semaphore> metal_device::create_semaphore() {
+    return metal_semaphore::create();
+}
+
+void metal_device::submit(const std::vector<graphics_submission>& submissions) {
+    // Enqueueing reserves the order on the queue, so offscreen work can be committed before the presenting command
+    // buffer is committed with its drawable
+    for (const auto& submission : submissions) {
+        auto command_buffer = ((const metal_command_buffer*) submission.command_buffer)->command_buffer();
+        [command_buffer enqueue];
+        if (submission.swapchain) _command_buffer_to_present = command_buffer;
+        else [command_buffer commit];
+    }
 }
 
 void metal_device::present(graphics_swapchain& swapchain) {
@@ -103,3 +143,22 @@ void metal_device::present(graphics_swapchain& swapchain) {
     [_command_buffer_to_present commit];
     _command_buffer_to_present = nullptr;
 }
+
+graphics_memory_stats metal_device::memory_stats() {
+    // Metal only reports totals for the whole device, so the per-kind breakdown is left empty
+    graphics_memory_stats stats;
+    stats.heaps.push_back({
+        .size = _device.recommendedMaxWorkingSetSize,
+        .device_local = true,
+        .usage = _device.currentAllocatedSize,
+        .budget = _device.recommendedMaxWorkingSetSize,
+        .allocation_bytes = _device.currentAllocatedSize,
+    });
+    return stats;
+}
+
+bool metal_device::transfer_complete(graphics_transfer_token token) {
+    return true;
+}
+
+void metal_device::wait_for_transfer(graphics_transfer_token token) { }
@@ -0,0 +1,22 @@
+#ifndef XGRAPHICS_METAL_GEOMETRY_ARENA_H
+#define XGRAPHICS_METAL_GEOMETRY_ARENA_H
+
+#import <Metal/Metal.h>
+#import <result/result.h>
+#import <xgraphics/interfaces/graphics_geometry_arena.h>
+
+class metal_geometry_arena : public graphics_geometry_arena {
+    id<MTLDevice> _device;
+
+    metal_geometry_arena(buffer_usage_flags usage, uint64_t block_size, id<MTLDevice> device);
+
+  protected:
+    result::ptr<graphics_buffer> create_block(buffer_usage_flags usage, uint64_t size) override;
+    void copy(const std::vector<graphics_geometry_copy>& copies) override;
+
+  public:
+    static result::ptr<graphics_geometry_arena> create(buffer_usage_flags usage, uint64_t block_size,
+                                                       id<MTLDevice> device);
+};
+
+#endif
@@ -0,0 +1,24 @@
+#import "metal_geometry_arena.h"
+
+#import "metal_buffer.h"
+
+metal_geometry_arena::metal_geometry_arena(buffer_usage_flags usage, uint64_t block_size, id<MTLDevice> device)
+    : graphics_geometry_arena(usage, block_size), _device(device) { }
+
+result::ptr<graphics_geometry_arena> metal_geometry_arena::create(buffer_usage_flags usage, uint64_t block_size,
+                                                                  id<MTLDevice> device) {
+    return result::ok(new metal_geometry_arena(usage, block_size, device));
+}
+
+result::ptr<graphics_buffer> metal_geometry_arena::create_block(buffer_usage_flags usage, uint64_t size) {
+    return metal_buffer::create(usage, size, _device);
+}
+
+void metal_geometry_arena::copy(const std::vector<graphics_geometry_copy>& copies) {
+    // Blocks use shared storage, and command buffers retain the old blocks for as long as they need them
+    for (const auto& copy : copies) {
+        auto src = ((const metal_buffer*) copy.src)->buffer();
+        auto dst = ((const metal_buffer*) copy.dst)->buffer();
+        memcpy((uint8_t*) dst.contents + copy.dst_offset, (const uint8_t*) src.contents + copy.src_offset, copy.size);
+    }
+}
@@ -7,16 +7,33 @@
 
 class metal_image : public graphics_image {
     id<MTLTexture> _texture;
+    id<MTLCommandQueue> _command_queue;
 
-    metal_image(uint32_t width, uint32_t height, graphics_image_format format, id<MTLTexture> texture);
+    metal_image(const graphics_image_init& init, id<MTLTexture> texture, id<MTLCommandQueue> command_queue);
+
+    void check_write(uint32_t mip_level) const;
+    void replace_layer(uint32_t layer, uint32_t mip_level, const void* data);
+    void generate_mipmaps();
 
   public:
-    static result::ptr<graphics_image> create(uint32_t width, uint32_t height, graphics_image_format format,
-                                              id<MTLDevice> device);
+    static result::ptr<graphics_image> create(const graphics_image_init& init, id<MTLDevice> device,
+                                              id<MTLCommandQueue> command_queue);
 
     [[nodiscard]] id<MTLTexture> texture() const;
 
-    void write(const void* data, uint32_t size) override;
+    void write(const void* data, uint64_t size) override;
+    graphics_transfer_token write_async(const void* data, uint64_t size) override;
+    void write_level(uint32_t mip_level, const void* data, uint64_t size) override;
+    graphics_transfer_token write_level_async(uint32_t mip_level, const void* data, uint64_t size) override;
+    void write_layer(uint32_t layer, uint32_t mip_level, const void* data, uint64_t size) override;
+    graphics_transfer_token write_layer_async(uint32_t layer, uint32_t mip_level, const void* data,
+                                              uint64_t size) override;
+    void write_region(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t mip_level, uint32_t layer,
+                      const void* data, uint64_t row_pitch) override;
+    std::unique_ptr<graphics_readback> read_async(uint32_t mip_level, uint32_t layer) override;
+
+    static MTLPixelFormat pixel_format(graphics_image_format format);
+    static bool format_supported(id<MTLDevice> device, graphics_image_format format);
 };
 
 #endif
@@ -1,47 +1,213 @@
 #import "metal_image.h"
+#import "metal_readback.h"
 
-metal_image::metal_image(uint32_t width, uint32_t height, graphics_image_format format, id<MTLTexture> texture)
-    : graphics_image(width, height, format), _texture(texture) { }
+metal_image::metal_image(const graphics_image_init& init, id<MTLTexture> texture, id<MTLCommandQueue> command_queue)
+    : graphics_image(init), _texture(texture), _command_queue(command_queue) { }
 
-result::ptr<graphics_image> metal_image::create(uint32_t width, uint32_t height, graphics_image_format format,
-                                                id<MTLDevice> device) {
+result::ptr<graphics_image> metal_image::create(const graphics_image_init& init, id<MTLDevice> device,
+                                                id<MTLCommandQueue> command_queue) {
+    if (!valid(init)) return result::err("Image size does not fit its type");
+    if (!format_supported(device, init.format)) return result::err("Unsupported pixel format");
+    if (init.mipmaps && compressed(init.format))
+        return result::err("Mipmaps cannot be generated for compressed image formats");
 
-    MTLPixelFormat pixel_format;
-    switch (format) {
-        case graphics_image_format::rgba_8_srgb:
-            pixel_format = MTLPixelFormatRGBA8Unorm_sRGB;
+    MTLTextureDescriptor* descriptor = [[MTLTextureDescriptor alloc] init];
+    descriptor.pixelFormat = pixel_format(init.format);
+    descriptor.width = init.width;
+    descriptor.height = init.height;
+    switch (init.type) {
+        case graphics_image_type::image_2d:
+            descriptor.textureType = MTLTextureType2D;
             break;
-        case graphics_image_format::rgba_8_unorm:
-            pixel_format = MTLPixelFormatRGBA8Unorm;
+        case graphics_image_type::image_2d_array:
+            descriptor.textureType = MTLTextureType2DArray;
+            descriptor.arrayLength = std::max(init.layers, 1u);
+            break;
+        case graphics_image_type::cube:
+            descriptor.textureType = MTLTextureTypeCube;
+            break;
+        case graphics_image_type::image_3d:
+            descriptor.textureType = MTLTextureType3D;
+            descriptor.depth = std::max(init.depth, 1u);
             break;
-        default:
-            return result::err("Unsupported pixel format");
     }
 
-    MTLTextureDescriptor* descriptor = [MTLTextureDescriptor texture2DDescriptorWithPixelFormat:pixel_format
-                                                                                          width:width
-                                                                                         height:height
-                                                                                      mipmapped:NO];
+    uint32_t depth = init.type == graphics_image_type::image_3d ? std::max(init.depth, 1u) : 1;
+    descriptor.mipmapLevelCount =
+        init.mipmaps ? mip_level_count(init.width, init.height, depth) : std::max(init.mip_levels, 1u);
     descriptor.usage = MTLTextureUsageShaderRead;
     id<MTLTexture> texture = [device newTextureWithDescriptor:descriptor];
-    return result::ok(new metal_image(width, height, format, texture));
+    return result::ok(new metal_image(init, texture, command_queue));
 }
 
 id<MTLTexture> metal_image::texture() const {
     return _texture;
 }
 
-void metal_image::write(const void* data, uint32_t size) {
-    int channels;
-    switch (format()) {
+void metal_image::write(const void* data, uint64_t size) {
+    write_level(0, data, size);
+}
+
+graphics_transfer_token metal_image::write_async(const void* data, uint64_t size) {
+    // replaceRegion copies synchronously, so there is never any pending transfer
+    write(data, size);
+    return {};
+}
+
+void metal_image::write_level(uint32_t mip_level, const void* data, uint64_t size) {
+    check_write(mip_level);
+    if (size != level_size(mip_level) * layers()) throw std::runtime_error("Image write size does not match the level");
+    for (uint32_t layer = 0; layer < layers(); layer++)
+        replace_layer(layer, mip_level, (const uint8_t*) data + layer * level_size(mip_level));
+    if (generates_mipmaps()) generate_mipmaps();
+}
+
+graphics_transfer_token metal_image::write_level_async(uint32_t mip_level, const void* data, uint64_t size) {
+    write_level(mip_level, data, size);
+    return {};
+}
+
+void metal_image::write_layer(uint32_t layer, uint32_t mip_level, const void* data, uint64_t size) {
+    check_write(mip_level);
+    if (layer >= layers()) throw std::runtime_error("Image layer is out of range");
+    if (size != level_size(mip_level)) throw std::runtime_error("Image write size does not match the level");
+    replace_layer(layer, mip_level, data);
+    if (generates_mipmaps()) generate_mipmaps();
+}
+
+graphics_transfer_token metal_image::write_layer_async(uint32_t layer, uint32_t mip_level, const void* data,
+                                                       uint64_t size) {
+    write_layer(layer, mip_level, data, size);
+    return {};
+}
+
+void metal_image::write_region(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t mip_level,
+                               uint32_t layer, const void* data, uint64_t row_pitch) {
+    if (immutable()) throw std::runtime_error("Cannot write to an immutable image");
+    if (generates_mipmaps()) throw std::runtime_error("Cannot write regions of an image with generated mipmaps");
+    check_region(x, y, width, height, mip_level, layer);
+
+    // Textures are written directly, so there is nothing to batch. Slices of 3D images are offsets into their only
+    // layer.
+    if (row_pitch == 0) row_pitch = region_row_pitch(width);
+    bool slice = type() == graphics_image_type::image_3d;
+    MTLRegion region = MTLRegionMake3D(x, y, slice ? layer : 0, width, height, 1);
+    [_texture replaceRegion:region
+                mipmapLevel:mip_level
+                      slice:slice ? 0 : layer
+                  withBytes:data
+                bytesPerRow:row_pitch
+              bytesPerImage:row_pitch * region_rows(height)];
+}
+
+std::unique_ptr<graphics_readback> metal_image::read_async(uint32_t mip_level, uint32_t layer) {
+    if (mip_level >= mip_levels()) throw std::runtime_error("Image mip level is out of range");
+    if (layer >= layers()) throw std::runtime_error("Image layer is out of range");
+
+    // Blitted on the queue that generates mipmaps, which orders the copy after them
+    uint64_t row_pitch = level_row_pitch(mip_level);
+    uint64_t size = level_size(mip_level);
+    uint32_t level_height = this->level_height(mip_level);
+    id<MTLBuffer> readback = [_texture.device newBufferWithLength:size options:MTLResourceStorageModeShared];
+
+    id<MTLCommandBuffer> command_buffer = [_command_queue commandBuffer];
+    id<MTLBlitCommandEncoder> encoder = [command_buffer blitCommandEncoder];
+    [encoder copyFromTexture:_texture
+                     sourceSlice:layer
+                     sourceLevel:mip_level
+                    sourceOrigin:MTLOriginMake(0, 0, 0)
+                      sourceSize:MTLSizeMake(level_width(mip_level), level_height, level_depth(mip_level))
+                        toBuffer:readback
+               destinationOffset:0
+          destinationBytesPerRow:row_pitch
+        destinationBytesPerImage:row_pitch * region_rows(level_height)];
+    [encoder endEncoding];
+    [command_buffer commit];
+
+    return std::make_unique<metal_readback>(readback, size, command_buffer);
+}
+
+void metal_image::check_write(uint32_t mip_level) const {
+    if (immutable()) throw std::runtime_error("Cannot write to an immutable image");
+    if (mip_level >= mip_levels()) throw std::runtime_error("Image mip level is out of range");
+    if (generates_mipmaps() && mip_level > 0) throw std::runtime_error("Cannot write to a generated mip level");
+}
+
+void metal_image::replace_layer(uint32_t layer, uint32_t mip_level, const void* data) {
+    // Compressed rows are rows of blocks, and each layer holds every depth slice of a 3D image
+    uint64_t row_pitch = level_row_pitch(mip_level);
+    uint32_t level_width = this->level_width(mip_level);
+    uint32_t level_height = this->level_height(mip_level);
+    MTLRegion region = MTLRegionMake3D(0, 0, 0, level_width, level_height, level_depth(mip_level));
+    [_texture replaceRegion:region
+                mipmapLevel:mip_level
+                      slice:layer
+                  withBytes:data
+                bytesPerRow:row_pitch
+              bytesPerImage:row_pitch * region_rows(level_height)];
+}
+
+void metal_image::generate_mipmaps() {
+    id<MTLCommandBuffer> command_buffer = [_command_queue commandBuffer];
+    id<MTLBlitCommandEncoder> encoder = [command_buffer blitCommandEncoder];
+    [encoder generateMipmapsForTexture:_texture];
+    [encoder endEncoding];
+    [command_buffer commit];
+}
+
+MTLPixelFormat metal_image::pixel_format(graphics_image_format format) {
+    switch (format) {
         case graphics_image_format::rgba_8_srgb:
+            return MTLPixelFormatRGBA8Unorm_sRGB;
         case graphics_image_format::rgba_8_unorm:
-            channels = 4;
-            break;
-        default:
-            return;
+            return MTLPixelFormatRGBA8Unorm;
+        case graphics_image_format::bc1_srgb:
+            return MTLPixelFormatBC1_RGBA_sRGB;
+        case graphics_image_format::bc1_unorm:
+            return MTLPixelFormatBC1_RGBA;
+        case graphics_image_format::bc3_srgb:
+            return MTLPixelFormatBC3_RGBA_sRGB;
+        case graphics_image_format::bc3_unorm:
+            return MTLPixelFormatBC3_RGBA;
+        case graphics_image_format::bc4_unorm:
+            return MTLPixelFormatBC4_RUnorm;
+        case graphics_image_format::bc5_unorm:
+            return MTLPixelFormatBC5_RGUnorm;
+        case graphics_image_format::bc7_srgb:
+            return MTLPixelFormatBC7_RGBAUnorm_sRGB;
+        case graphics_image_format::bc7_unorm:
+            return MTLPixelFormatBC7_RGBAUnorm;
+        case graphics_image_format::etc2_rgba_8_srgb:
+            return MTLPixelFormatEAC_RGBA8_sRGB;
+        case graphics_image_format::etc2_rgba_8_unorm:
+            return MTLPixelFormatEAC_RGBA8;
+        case graphics_image_format::astc_4x4_srgb:
+            return MTLPixelFormatASTC_4x4_sRGB;
+        case graphics_image_format::astc_4x4_unorm:
+            return MTLPixelFormatASTC_4x4_LDR;
     }
+    return MTLPixelFormatInvalid;
+}
 
-    MTLRegion region = MTLRegionMake2D(0, 0, width(), height());
-    [_texture replaceRegion:region mipmapLevel:0 withBytes:data bytesPerRow:width() * channels];
+bool metal_image::format_supported(id<MTLDevice> device, graphics_image_format format) {
+    switch (format) {
+        case graphics_image_format::rgba_8_srgb:
+        case graphics_image_format::rgba_8_unorm:
+            return true;
+        case graphics_image_format::bc1_srgb:
+        case graphics_image_format::bc1_unorm:
+        case graphics_image_format::bc3_srgb:
+        case graphics_image_format::bc3_unorm:
+        case graphics_image_format::bc4_unorm:
+        case graphics_image_format::bc5_unorm:
+        case graphics_image_format::bc7_srgb:
+        case graphics_image_format::bc7_unorm:
+            return device.supportsBCTextureCompression;
+        case graphics_image_format::etc2_rgba_8_srgb:
+        case graphics_image_format::etc2_rgba_8_unorm:
+        case graphics_image_format::astc_4x4_srgb:
+        case graphics_image_format::astc_4x4_unorm:
+            return [device supportsFamily:MTLGPUFamilyApple2];
+    }
+    return false;
 }
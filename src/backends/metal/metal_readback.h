@@ -0,0 +1,20 @@
+#ifndef XGRAPHICS_METAL_READBACK_H
+#define XGRAPHICS_METAL_READBACK_H
+
+#import <Metal/Metal.h>
+#import <xgraphics/interfaces/graphics_readback.h>
+
+// Shared memory that a blit copies into, or that was already filled when there is no command buffer
+class metal_readback : public graphics_readback {
+    id<MTLBuffer> _buffer;
+    id<MTLCommandBuffer> _command_buffer;
+
+  public:
+    metal_readback(id<MTLBuffer> buffer, uint64_t size, id<MTLCommandBuffer> command_buffer);
+
+    bool ready() override;
+    void wait() override;
+    const void* data() override;
+};
+
+#endif
@@ -0,0 +1,17 @@
+#import "metal_readback.h"
+
+metal_readback::metal_readback(id<MTLBuffer> buffer, uint64_t size, id<MTLCommandBuffer> command_buffer)
+    : graphics_readback(size), _buffer(buffer), _command_buffer(command_buffer) { }
+
+bool metal_readback::ready() {
+    return _command_buffer == nil || _command_buffer.status == MTLCommandBufferStatusCompleted;
+}
+
+void metal_readback::wait() {
+    if (_command_buffer != nil) [_command_buffer waitUntilCompleted];
+}
+
+const void* metal_readback::data() {
+    wait();
+    return _buffer.contents;
+}
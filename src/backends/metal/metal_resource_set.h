@@ -38,6 +38,8 @@ class metal_resource_set : public graphics_resource_set {
 
     // TODO: Make order of functions, override functions, and getters consistent
     void bind_uniform_buffer(resource_binding_ref binding, const graphics_uniform_buffer& buffer) override;
+    void bind_uniform_buffer(resource_binding_ref binding, const graphics_buffer& buffer, uint64_t offset,
+                             uint64_t size) override;
     void bind_sampled_image(resource_binding_ref binding, const graphics_image& image,
                             const graphics_sampler& sampler) override;
 
@@ -48,6 +50,7 @@ class metal_resource_set : public graphics_resource_set {
 
   private:
     void bind_uniform_buffer(resource_binding_ref binding, const metal_uniform_buffer& buffer, stage_info& info);
+    void bind_uniform_buffer(resource_binding_ref binding, id<MTLBuffer> buffer, uint64_t offset, stage_info& info);
     void bind_sampled_image(resource_binding_ref binding, const metal_image& image, const metal_sampler& sampler,
                             stage_info& info);
     void bind_resources(resource_binding_ref binding, const std::vector<id<MTLResource>>& resources, stage_info& info);
@@ -1,5 +1,6 @@
 #import "metal_resource_set.h"
 
+#import "metal_buffer.h"
 #import "metal_shader.h"
 
 metal_resource_set::metal_resource_set(const metal_resource_layout& layout, resource_set_ref ref,
@@ -74,6 +75,26 @@ void metal_resource_set::bind_uniform_buffer(resource_binding_ref binding, const
     bind_resources(binding, resources, info);
 }
 
+void metal_resource_set::bind_uniform_buffer(resource_binding_ref binding, const graphics_buffer& buffer,
+                                             uint64_t offset, uint64_t size) {
+    const auto& native_buffer = (const metal_buffer&) buffer;
+
+    bind_uniform_buffer(binding, native_buffer.buffer(), offset, _vertex_info);
+    bind_uniform_buffer(binding, native_buffer.buffer(), offset, _fragment_info);
+}
+
+void metal_resource_set::bind_uniform_buffer(resource_binding_ref binding, id<MTLBuffer> buffer, uint64_t offset,
+                                             metal_resource_set::stage_info& info) {
+    if (!info.bindings.contains(binding->source_binding)) return;
+
+    // Only the current frame's arguments, the others may still be read by frames in flight
+    auto& argument = info.arguments[_sync_context->current_frame()];
+    [argument.encoder setBuffer:buffer offset:offset atIndex:binding->backend_binding];
+    [argument.buffer didModifyRange:NSMakeRange(0, argument.encoder.encodedLength)];
+
+    bind_resources(binding, {buffer}, info);
+}
+
 void metal_resource_set::bind_sampled_image(resource_binding_ref binding, const graphics_image& image,
                                             const graphics_sampler& sampler) {
     const auto& native_image = (const metal_image&) image;
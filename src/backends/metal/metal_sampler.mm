@@ -10,10 +10,12 @@ result::ptr<graphics_sampler> metal_sampler::create(const graphics_sampler_init&
     descriptor.rAddressMode = mtl_address_mode(init.address_mode.w).get();
     descriptor.minFilter = mtl_filter(init.min_filter).get();
     descriptor.magFilter = mtl_filter(init.mag_filter).get();
-    descriptor.mipFilter = MTLSamplerMipFilterNotMipmapped;
+    descriptor.mipFilter = MTLSamplerMipFilterLinear;
     descriptor.normalizedCoordinates = YES;
-    descriptor.lodMinClamp = 0.0;
-    descriptor.lodMaxClamp = 0.0;
+
+    // Metal samplers have no LOD bias, it has to be applied in the shader instead
+    descriptor.lodMinClamp = init.min_lod;
+    descriptor.lodMaxClamp = init.max_lod;
     descriptor.maxAnisotropy = init.enable_anisotropy ? init.max_anisotropy : 1.0f;
     descriptor.compareFunction = MTLCompareFunctionAlways;
     descriptor.supportArgumentBuffers = YES;
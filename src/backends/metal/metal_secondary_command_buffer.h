@@ -0,0 +1,43 @@
+#ifndef XGRAPHICS_METAL_SECONDARY_COMMAND_BUFFER_H
+#define XGRAPHICS_METAL_SECONDARY_COMMAND_BUFFER_H
+
+#import <functional>
+#import <result/result.h>
+#import <vector>
+#import <xgraphics/interfaces/graphics_secondary_command_buffer.h>
+
+// Keeps the recorded commands, which are encoded into the render pass of the primary command buffer executing them
+class metal_secondary_command_buffer : public graphics_secondary_command_buffer {
+    std::vector<std::function<void(graphics_command_recorder&)>> _commands;
+    graphics_command_stats _stats;
+
+    explicit metal_secondary_command_buffer() = default;
+
+  public:
+    using graphics_secondary_command_buffer::draw;
+    using graphics_secondary_command_buffer::draw_indexed;
+
+    static result::ptr<graphics_secondary_command_buffer> create();
+
+    void execute(graphics_command_recorder& recorder) const;
+
+    void begin(const graphics_render_pass& render_pass) override;
+    void end() override;
+    void bind_pipeline(const graphics_pipeline& pipeline) override;
+    void bind_vertex_buffers(uint32_t first_index, std::span<const graphics_vertex_buffer_binding> buffers) override;
+    void bind_index_buffer(const graphics_buffer& buffer, uint64_t offset, index_type type) override;
+    void bind_resource_set(const graphics_resource_set& resource_set) override;
+    void draw(uint32_t vertex_start, uint32_t vertex_count, uint32_t instance_start, uint32_t instance_count) override;
+    void draw_indexed(uint32_t index_start, uint32_t index_count, uint32_t vertex_offset, uint32_t instance_start,
+                      uint32_t instance_count) override;
+    void draw_indirect(const graphics_buffer& buffer, uint64_t offset, uint32_t draw_count) override;
+    void draw_indexed_indirect(const graphics_buffer& buffer, uint64_t offset, uint32_t draw_count) override;
+    void draw_indirect_count(const graphics_buffer& buffer, uint64_t offset, const graphics_buffer& count_buffer,
+                             uint64_t count_offset, uint32_t max_draw_count) override;
+    void draw_indexed_indirect_count(const graphics_buffer& buffer, uint64_t offset,
+                                     const graphics_buffer& count_buffer, uint64_t count_offset,
+                                     uint32_t max_draw_count) override;
+    [[nodiscard]] graphics_command_stats stats() const override;
+};
+
+#endif
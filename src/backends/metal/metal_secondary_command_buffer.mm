@@ -0,0 +1,93 @@
+#include "metal_secondary_command_buffer.h"
+
+result::ptr<graphics_secondary_command_buffer> metal_secondary_command_buffer::create() {
+    return result::ok(new metal_secondary_command_buffer());
+}
+
+void metal_secondary_command_buffer::execute(graphics_command_recorder& recorder) const {
+    for (const auto& command : _commands)
+        command(recorder);
+}
+
+void metal_secondary_command_buffer::begin(const graphics_render_pass& render_pass) {
+    _commands.clear();
+    _stats = {};
+}
+
+void metal_secondary_command_buffer::end() { }
+
+void metal_secondary_command_buffer::bind_pipeline(const graphics_pipeline& pipeline) {
+    _commands.emplace_back([&pipeline](graphics_command_recorder& recorder) { recorder.bind_pipeline(pipeline); });
+    _stats.pipeline_binds++;
+}
+
+void metal_secondary_command_buffer::bind_vertex_buffers(uint32_t first_index,
+                                                         std::span<const graphics_vertex_buffer_binding> buffers) {
+    std::vector<graphics_vertex_buffer_binding> bindings(buffers.begin(), buffers.end());
+    _commands.emplace_back([first_index, bindings](graphics_command_recorder& recorder) {
+        recorder.bind_vertex_buffers(first_index, bindings);
+    });
+    _stats.vertex_buffer_binds += buffers.size();
+}
+
+void metal_secondary_command_buffer::bind_index_buffer(const graphics_buffer& buffer, uint64_t offset,
+                                                       index_type type) {
+    _commands.emplace_back([&buffer, offset, type](graphics_command_recorder& recorder) {
+        recorder.bind_index_buffer(buffer, offset, type);
+    });
+    _stats.index_buffer_binds++;
+}
+
+void metal_secondary_command_buffer::bind_resource_set(const graphics_resource_set& resource_set) {
+    _commands.emplace_back(
+        [&resource_set](graphics_command_recorder& recorder) { recorder.bind_resource_set(resource_set); });
+    _stats.resource_set_binds++;
+}
+
+void metal_secondary_command_buffer::draw(uint32_t vertex_start, uint32_t vertex_count, uint32_t instance_start,
+                                          uint32_t instance_count) {
+    _commands.emplace_back([=](graphics_command_recorder& recorder) {
+        recorder.draw(vertex_start, vertex_count, instance_start, instance_count);
+    });
+    _stats.draws++;
+}
+
+void metal_secondary_command_buffer::draw_indexed(uint32_t index_start, uint32_t index_count, uint32_t vertex_offset,
+                                                  uint32_t instance_start, uint32_t instance_count) {
+    _commands.emplace_back([=](graphics_command_recorder& recorder) {
+        recorder.draw_indexed(index_start, index_count, vertex_offset, instance_start, instance_count);
+    });
+    _stats.draws++;
+}
+
+void metal_secondary_command_buffer::draw_indirect(const graphics_buffer& buffer, uint64_t offset,
+                                                   uint32_t draw_count) {
+    _commands.emplace_back([&buffer, offset, draw_count](graphics_command_recorder& recorder) {
+        recorder.draw_indirect(buffer, offset, draw_count);
+    });
+    _stats.draws++;
+}
+
+void metal_secondary_command_buffer::draw_indexed_indirect(const graphics_buffer& buffer, uint64_t offset,
+                                                           uint32_t draw_count) {
+    _commands.emplace_back([&buffer, offset, draw_count](graphics_command_recorder& recorder) {
+        recorder.draw_indexed_indirect(buffer, offset, draw_count);
+    });
+    _stats.draws++;
+}
+
+void metal_secondary_command_buffer::draw_indirect_count(const graphics_buffer& buffer, uint64_t offset,
+                                                         const graphics_buffer& count_buffer, uint64_t count_offset,
+                                                         uint32_t max_draw_count) {
+    throw std::runtime_error("Indirect draw counts are not supported");
+}
+
+void metal_secondary_command_buffer::draw_indexed_indirect_count(const graphics_buffer& buffer, uint64_t offset,
+                                                                 const graphics_buffer& count_buffer,
+                                                                 uint64_t count_offset, uint32_t max_draw_count) {
+    throw std::runtime_error("Indirect draw counts are not supported");
+}
+
+graphics_command_stats metal_secondary_command_buffer::stats() const {
+    return _stats;
+}
@@ -0,0 +1,15 @@
+#ifndef XGRAPHICS_METAL_SEMAPHORE_H
+#define XGRAPHICS_METAL_SEMAPHORE_H
+
+#import <result/result.h>
+#import <xgraphics/interfaces/graphics_semaphore.h>
+
+// Command buffers of the single queue already run in the order they are submitted, so there is nothing to signal
+class metal_semaphore : public graphics_semaphore {
+    explicit metal_semaphore() = default;
+
+  public:
+    static result::ptr<graphics_semaphore> create();
+};
+
+#endif
@@ -0,0 +1,5 @@
+#include "metal_semaphore.h"
+
+result::ptr<graphics_semaphore> metal_semaphore::create() {
+    return result::ok(new metal_semaphore());
+}
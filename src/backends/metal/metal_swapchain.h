@@ -9,16 +9,20 @@ class metal_swapchain : public graphics_swapchain {
     CAMetalLayer* _layer;
     id<CAMetalDrawable> _current_drawable = nullptr;
     id<MTLTexture> _depth_stencil_texture;
+    graphics_present_mode _present_mode;
 
     explicit metal_swapchain(CAMetalLayer* layer, uint32_t width, uint32_t height,
-                             id<MTLTexture> depth_stencil_texture);
+                             id<MTLTexture> depth_stencil_texture, graphics_present_mode present_mode);
 
   public:
+    // The layer either syncs to the display or not at all, and only keeps 2 or 3 drawables
     static result::ptr<graphics_swapchain> create(id<MTLDevice> device, CAMetalLayer* layer, uint32_t width,
-                                                  uint32_t height);
+                                                  uint32_t height, const graphics_config& config);
 
     [[nodiscard]] id<CAMetalDrawable> current_drawable() const;
     [[nodiscard]] id<MTLTexture> depth_stencil_texture() const;
+    [[nodiscard]] graphics_present_mode present_mode() const override;
+    [[nodiscard]] uint32_t image_count() const override;
 
     void swap() override;
     void resize(uint32_t width, uint32_t height) override;
@@ -1,16 +1,25 @@
 #include "metal_swapchain.h"
+#include <algorithm>
 
 metal_swapchain::metal_swapchain(CAMetalLayer* layer, uint32_t width, uint32_t height,
-                                 id<MTLTexture> depth_stencil_texture)
-    : graphics_swapchain(width, height), _layer(layer), _depth_stencil_texture(depth_stencil_texture) { }
+                                 id<MTLTexture> depth_stencil_texture, graphics_present_mode present_mode)
+    : graphics_swapchain(width, height),
+      _layer(layer),
+      _depth_stencil_texture(depth_stencil_texture),
+      _present_mode(present_mode) { }
 
 result::ptr<graphics_swapchain> metal_swapchain::create(id<MTLDevice> device, CAMetalLayer* layer, uint32_t width,
-                                                        uint32_t height) {
+                                                        uint32_t height, const graphics_config& config) {
     layer.pixelFormat = MTLPixelFormatBGRA8Unorm_sRGB;
     layer.drawableSize = CGSizeMake(width, height);
 
+    auto present_mode = graphics_swapchain::choose_present_mode(
+        config.present_modes, {graphics_present_mode::fifo, graphics_present_mode::immediate});
+    layer.displaySyncEnabled = present_mode == graphics_present_mode::fifo;
+    if (config.swapchain_images > 0) layer.maximumDrawableCount = std::clamp(config.swapchain_images, 2u, 3u);
+
     auto depth_stencil_texture = create_depth_stencil_texture(device, width, height);
-    return result::ok(new metal_swapchain(layer, width, height, depth_stencil_texture));
+    return result::ok(new metal_swapchain(layer, width, height, depth_stencil_texture, present_mode));
 }
 
 id<CAMetalDrawable> metal_swapchain::current_drawable() const {
@@ -21,6 +30,14 @@ id<MTLTexture> metal_swapchain::depth_stencil_texture() const {
     return _depth_stencil_texture;
 }
 
+graphics_present_mode metal_swapchain::present_mode() const {
+    return _present_mode;
+}
+
+uint32_t metal_swapchain::image_count() const {
+    return (uint32_t) _layer.maximumDrawableCount;
+}
+
 void metal_swapchain::swap() {
     _current_drawable = [_layer nextDrawable];
 }
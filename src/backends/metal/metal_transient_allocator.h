@@ -0,0 +1,38 @@
+#ifndef XGRAPHICS_METAL_TRANSIENT_ALLOCATOR_H
+#define XGRAPHICS_METAL_TRANSIENT_ALLOCATOR_H
+
+#import <Metal/Metal.h>
+#import <memory>
+#import <result/result.h>
+#import <vector>
+#import <xgraphics/interfaces/graphics_transient.h>
+
+struct metal_transient_chunk {
+    std::unique_ptr<graphics_buffer> buffer;
+    uint64_t size;
+    uint64_t offset;
+};
+
+// One region of shared storage per frame in flight, reset once the frame that last used it has completed
+class metal_transient_allocator {
+    id<MTLDevice> _device;
+    std::vector<std::vector<metal_transient_chunk>> _regions;
+    uint32_t _current_region = 0;
+
+    metal_transient_allocator(id<MTLDevice> device, uint32_t frames_in_flight);
+
+  public:
+    static constexpr uint64_t CHUNK_SIZE = 1024 * 1024;
+    static constexpr uint32_t ALIGNMENT = 256;
+    static constexpr buffer_usage_flags TRANSIENT_USAGE = buffer_usage::vertex | buffer_usage::index |
+                                                          buffer_usage::uniform | buffer_usage::indirect;
+
+    metal_transient_allocator(const metal_transient_allocator&) = delete;
+
+    static result::ptr<metal_transient_allocator> create(id<MTLDevice> device, uint32_t frames_in_flight);
+
+    [[nodiscard]] graphics_transient_allocation allocate(buffer_usage_flags usage, uint64_t size);
+    void reset(uint32_t region);
+};
+
+#endif
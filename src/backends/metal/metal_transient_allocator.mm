@@ -0,0 +1,60 @@
+#import "metal_transient_allocator.h"
+
+#import "metal_buffer.h"
+
+metal_transient_allocator::metal_transient_allocator(id<MTLDevice> device, uint32_t frames_in_flight)
+    : _device(device), _regions(frames_in_flight) { }
+
+result::ptr<metal_transient_allocator> metal_transient_allocator::create(id<MTLDevice> device,
+                                                                         uint32_t frames_in_flight) {
+    auto allocator =
+        std::unique_ptr<metal_transient_allocator>(new metal_transient_allocator(device, frames_in_flight));
+    for (auto& region : allocator->_regions)
+        region.push_back({GET_OR_FORWARD(metal_buffer::create(TRANSIENT_USAGE, CHUNK_SIZE, device)), CHUNK_SIZE, 0});
+
+    return result::ok(allocator.release());
+}
+
+graphics_transient_allocation metal_transient_allocator::allocate(buffer_usage_flags usage, uint64_t size) {
+    auto& chunks = _regions[_current_region];
+
+    // Buffer offsets bound as uniforms need the largest alignment, so every allocation uses it
+    auto* chunk = &chunks.back();
+    uint64_t offset = (chunk->offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    if (offset + size > chunk->size) {
+        uint64_t chunk_size = std::max(size, CHUNK_SIZE);
+        auto buffer = metal_buffer::create(TRANSIENT_USAGE, chunk_size, _device);
+        if (!buffer.is_ok()) throw std::runtime_error("Failed to grow transient memory");
+
+        chunks.push_back({std::move(buffer.get()), chunk_size, 0});
+        chunk = &chunks.back();
+        offset = 0;
+    }
+
+    chunk->offset = offset + size;
+    auto* buffer = (const metal_buffer*) chunk->buffer.get();
+    return {
+        .buffer = buffer,
+        .offset = offset,
+        .size = size,
+        .data = (uint8_t*) buffer->buffer().contents + offset,
+    };
+}
+
+void metal_transient_allocator::reset(uint32_t region) {
+    _current_region = region;
+    auto& chunks = _regions[region];
+
+    if (chunks.size() > 1) {
+        uint64_t total_size = 0;
+        for (const auto& chunk : chunks)
+            total_size += chunk.size;
+        chunks.clear();
+
+        auto buffer = metal_buffer::create(TRANSIENT_USAGE, total_size, _device);
+        if (!buffer.is_ok()) throw std::runtime_error("Failed to resize transient memory");
+        chunks.push_back({std::move(buffer.get()), total_size, 0});
+    }
+
+    chunks.back().offset = 0;
+}
@@ -0,0 +1,21 @@
+#ifndef XGRAPHICS_METAL_UPLOAD_BATCH_H
+#define XGRAPHICS_METAL_UPLOAD_BATCH_H
+
+#import <result/result.h>
+#import <xgraphics/interfaces/graphics_upload_batch.h>
+
+// Buffers and textures use shared storage, so writes are applied immediately and there is nothing to submit
+class metal_upload_batch : public graphics_upload_batch {
+    metal_upload_batch() = default;
+
+  protected:
+    void record_write(graphics_buffer& buffer, const void* data, uint64_t size) override;
+    void record_write(graphics_image& image, const void* data, uint64_t size) override;
+    graphics_transfer_token submit_writes() override;
+    void wait_for_writes(graphics_transfer_token token) override;
+
+  public:
+    static result::ptr<graphics_upload_batch> create();
+};
+
+#endif
@@ -0,0 +1,19 @@
+#import "metal_upload_batch.h"
+
+result::ptr<graphics_upload_batch> metal_upload_batch::create() {
+    return result::ok(new metal_upload_batch());
+}
+
+void metal_upload_batch::record_write(graphics_buffer& buffer, const void* data, uint64_t size) {
+    buffer.write(data, size);
+}
+
+void metal_upload_batch::record_write(graphics_image& image, const void* data, uint64_t size) {
+    image.write(data, size);
+}
+
+graphics_transfer_token metal_upload_batch::submit_writes() {
+    return {};
+}
+
+void metal_upload_batch::wait_for_writes(graphics_transfer_token token) { }
@@ -1,43 +1,30 @@
 #include "vulkan_buffer.h"
+#include "vulkan_readback.h"
 
-vulkan_buffer::vulkan_buffer(const vulkan_buffer_init& init, VkBuffer staging_buffer, VkBuffer buffer)
+vulkan_buffer::vulkan_buffer(const vulkan_buffer_init& init, const vulkan_buffer_allocation& buffer)
     : graphics_buffer(init.usage, init.size),
       _device(init.device),
       _memory_context(init.memory_context),
-      _staging_buffer(staging_buffer),
       _buffer(buffer),
-      _transfer_command_pool(init.transfer_command_pool),
-      _transfer_queue(init.transfer_queue) { }
+      _transfer_context(init.transfer_context),
+      _deletion_queue(init.deletion_queue) { }
 
 vulkan_buffer::~vulkan_buffer() {
-    _memory_context.destroy_buffer(_staging_buffer);
-    _memory_context.destroy_buffer(_buffer);
+    if (!_dirty_ranges.empty()) _transfer_context.cancel_deferred(this);
+    _transfer_context.wait(_last_transfer);
+    _deletion_queue.release([&memory_context = _memory_context, buffer = _buffer] {
+        memory_context.destroy_buffer(buffer);
+    });
 }
 
 result::ptr<graphics_buffer> vulkan_buffer::create(const vulkan_buffer_init& init) {
     auto size = init.size;
 
-    VkBufferCreateInfo staging_buffer_info = {
-        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-        .size = size,
-        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-        .queueFamilyIndexCount = 0,
-        .pQueueFamilyIndices = nullptr,
-    };
-
-    if (init.def.transfer_family != init.def.graphics_family) {
-        uint32_t queue_family_indices[] = {init.def.transfer_family.value(), init.def.graphics_family.value()};
-        staging_buffer_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
-        staging_buffer_info.queueFamilyIndexCount = 2;
-        staging_buffer_info.pQueueFamilyIndices = queue_family_indices;
-    }
-
-    auto staging_buffer = GET_OR_FORWARD(init.memory_context.create_staging_buffer(staging_buffer_info));
-
-    VkBufferUsageFlags flags = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    VkBufferUsageFlags flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
     if (init.usage & (int) buffer_usage::vertex) flags |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
     if (init.usage & (int) buffer_usage::index) flags |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    if (init.usage & (int) buffer_usage::uniform) flags |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    if (init.usage & (int) buffer_usage::indirect) flags |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
 
     VkBufferCreateInfo buffer_info = {
         .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
@@ -46,59 +33,180 @@ result::ptr<graphics_buffer> vulkan_buffer::create(const vulkan_buffer_init& ini
         .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
     };
 
-    auto buffer = GET_OR_FORWARD(init.memory_context.create_gpu_buffer(buffer_info));
-    return result::ok(new vulkan_buffer(init, staging_buffer, buffer));
+    // Buffers with several usages are counted as the first of them
+    auto kind = vulkan_memory_kind::other_buffer;
+    if (init.usage & (int) buffer_usage::uniform) kind = vulkan_memory_kind::uniform_buffer;
+    else if (init.usage & (int) buffer_usage::vertex) kind = vulkan_memory_kind::vertex_buffer;
+    else if (init.usage & (int) buffer_usage::index) kind = vulkan_memory_kind::index_buffer;
+    else if (init.usage & (int) buffer_usage::indirect) kind = vulkan_memory_kind::indirect_buffer;
+
+    // Device local memory that the host can write to needs no staging copy
+    vulkan_buffer_allocation buffer;
+    if (init.mapped)
+        buffer = GET_OR_FORWARD(init.memory_context.create_mapped_buffer(buffer_info, kind));
+    else if (init.memory_context.has_host_visible_device_memory())
+        buffer = GET_OR_FORWARD(init.memory_context.create_host_visible_gpu_buffer(buffer_info, kind));
+    else
+        buffer = GET_OR_FORWARD(init.memory_context.create_gpu_buffer(buffer_info, kind));
+
+    return result::ok(new vulkan_buffer(init, buffer));
 }
 
 VkBuffer vulkan_buffer::buffer() const {
-    return _buffer;
+    return _buffer.buffer;
 }
 
-void vulkan_buffer::write(const void* data, uint32_t size) {
-    // Map and copy to staging buffer
-    void* mapped_data = _memory_context.map_buffer(_staging_buffer);
-    memcpy(mapped_data, data, size);
-    _memory_context.unmap_buffer(_staging_buffer);
-
-    // Create transfer command buffer
-    VkCommandBufferAllocateInfo alloc_info = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-        .commandPool = _transfer_command_pool,
-        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandBufferCount = 1,
-    };
+bool vulkan_buffer::host_visible() const {
+    return _buffer.mapped_data != nullptr;
+}
 
-    VkCommandBuffer command_buffer;
-    if (vkAllocateCommandBuffers(_device, &alloc_info, &command_buffer) != VK_SUCCESS)
-        throw std::runtime_error("Failed to allocate transfer command buffer");
+void* vulkan_buffer::mapped_data() const {
+    return _buffer.mapped_data;
+}
 
-    // Begin command buffer
-    VkCommandBufferBeginInfo begin_info = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-    };
+void vulkan_buffer::flush(uint64_t offset, uint64_t size) const {
+    _memory_context.flush(_buffer.allocation, offset, size);
+}
 
-    if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS)
-        throw std::runtime_error("Failed to begin transfer command buffer");
+void vulkan_buffer::write(uint64_t offset, const void* data, uint64_t size) {
+    _transfer_context.wait(write_async(offset, data, size));
+}
 
-    // Copy staging buffer to GPU buffer
-    VkBufferCopy copy_region = {.size = size};
-    vkCmdCopyBuffer(command_buffer, _staging_buffer, _buffer, 1, &copy_region);
+graphics_transfer_token vulkan_buffer::write_async(uint64_t offset, const void* data, uint64_t size) {
+    if (immutable()) throw std::runtime_error("Cannot write to an immutable buffer");
+    if (offset > this->size() || size > this->size() - offset) throw std::runtime_error("Buffer write is out of range");
 
-    // Submit transfer command buffer
-    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
-        throw std::runtime_error("Failed to end transfer command buffer");
+    if (_buffer.mapped_data) {
+        memcpy((uint8_t*) _buffer.mapped_data + offset, data, size);
+        _memory_context.flush(_buffer.allocation, offset, size);
+        return {};
+    }
 
-    VkSubmitInfo submit_info = {
-        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .commandBufferCount = 1,
-        .pCommandBuffers = &command_buffer,
-    };
+    update_dirty_ranges(offset, data, size);
+
+    if (size > vulkan_staging_ring::STREAM_CHUNK_SIZE) {
+        _last_transfer = _transfer_context.stream(_buffer.buffer, offset, data, size);
+        return _last_transfer;
+    }
+
+    // Copy to staging memory
+    auto staging = _transfer_context.allocate_staging(size);
+    memcpy(staging.data, data, size);
+    _transfer_context.flush_staging(staging, size);
+
+    // Copy staging memory to GPU buffer
+    VkCommandBuffer command_buffer = _transfer_context.begin();
+    VkBufferCopy copy_region = {.srcOffset = staging.offset, .dstOffset = offset, .size = size};
+    vkCmdCopyBuffer(command_buffer, staging.buffer, _buffer.buffer, 1, &copy_region);
+
+    _last_transfer = _transfer_context.submit(command_buffer);
+    return _last_transfer;
+}
+
+void vulkan_buffer::write_deferred(uint64_t offset, const void* data, uint64_t size) {
+    if (immutable()) throw std::runtime_error("Cannot write to an immutable buffer");
+    if (offset > this->size() || size > this->size() - offset) throw std::runtime_error("Buffer write is out of range");
+
+    // Large writes are streamed right away rather than staged in one piece with the other deferred writes. Pending
+    // ranges that overlap are updated with the new data, so they do not overwrite it when they are flushed.
+    if (_buffer.mapped_data || size > vulkan_staging_ring::STREAM_CHUNK_SIZE) {
+        write_async(offset, data, size);
+        return;
+    }
+
+    if (_dirty_ranges.empty()) _transfer_context.defer(this);
+
+    // Find every range that overlaps or touches the new one
+    uint64_t begin = offset;
+    uint64_t end = offset + size;
+    auto first = _dirty_ranges.upper_bound(begin);
+    if (first != _dirty_ranges.begin() && std::prev(first)->first + std::prev(first)->second.size() >= begin) first--;
+    auto last = first;
+    while (last != _dirty_ranges.end() && last->first <= end)
+        last++;
+
+    // Rewrites within a single range are copied in place
+    if (first != last) {
+        begin = std::min(begin, first->first);
+        end = std::max(end, std::prev(last)->first + std::prev(last)->second.size());
+        if (std::next(first) == last && begin == first->first && end == begin + first->second.size()) {
+            memcpy(first->second.data() + (offset - begin), data, size);
+            return;
+        }
+    }
 
-    if (vkQueueSubmit(_transfer_queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS)
-        throw std::runtime_error("Failed to submit transfer command buffer");
+    // Otherwise the ranges are merged into one, with the new data over them
+    std::vector<uint8_t> range(end - begin);
+    for (auto it = first; it != last; it++)
+        memcpy(range.data() + (it->first - begin), it->second.data(), it->second.size());
+    memcpy(range.data() + (offset - begin), data, size);
+    _dirty_ranges.erase(first, last);
+    _dirty_ranges[begin] = std::move(range);
+}
+
+void vulkan_buffer::update_dirty_ranges(uint64_t offset, const void* data, uint64_t size) {
+    auto it = _dirty_ranges.upper_bound(offset);
+    if (it != _dirty_ranges.begin()) it--;
+
+    for (; it != _dirty_ranges.end() && it->first < offset + size; it++) {
+        uint64_t begin = std::max(offset, it->first);
+        uint64_t end = std::min(offset + size, it->first + it->second.size());
+        if (begin < end)
+            memcpy(it->second.data() + (begin - it->first), (const uint8_t*) data + (begin - offset), end - begin);
+    }
+}
 
-    vkQueueWaitIdle(_transfer_queue);
+std::unique_ptr<graphics_readback> vulkan_buffer::read_async(uint64_t offset, uint64_t size) {
+    if (offset > this->size() || size > this->size() - offset) throw std::runtime_error("Buffer read is out of range");
+
+    // Deferred writes must reach the buffer before it is copied
+    if (!_dirty_ranges.empty()) _transfer_context.flush_deferred();
+
+    auto readback = _transfer_context.readback_pool().acquire(size);
+    if (!readback.is_ok()) throw std::runtime_error("Failed to allocate readback memory: " + readback.error());
+    VkCommandBuffer command_buffer = _transfer_context.begin();
+    VkBufferCopy copy_region = {.srcOffset = offset, .dstOffset = 0, .size = size};
+    vkCmdCopyBuffer(command_buffer, _buffer.buffer, readback.get().buffer, 1, &copy_region);
+    vulkan_readback_pool::record_host_read_barrier(command_buffer);
+
+    // Nothing on the graphics queue depends on the copy
+    _last_transfer = _transfer_context.submit(command_buffer, false);
+    return std::make_unique<vulkan_readback>(_transfer_context, readback.get(), size, _last_transfer);
+}
+
+void vulkan_buffer::track_transfer(graphics_transfer_token token) {
+    _last_transfer = token;
+}
+
+void vulkan_buffer::record_deferred_writes(VkCommandBuffer command_buffer) {
+    VkDeviceSize total_size = 0;
+    for (const auto& [offset, range] : _dirty_ranges)
+        total_size += range.size();
+
+    // Staging memory stays bounded however much of the buffer is dirty. The ranges are disjoint, so the streamed
+    // copies need no ordering against the command buffer.
+    if (total_size > vulkan_staging_ring::STREAM_CHUNK_SIZE) {
+        for (const auto& [offset, range] : _dirty_ranges)
+            _last_transfer = _transfer_context.stream(_buffer.buffer, offset, range.data(), range.size());
+        _dirty_ranges.clear();
+        return;
+    }
+
+    // Pack every range into one staging allocation
+    auto staging = _transfer_context.allocate_staging(total_size);
+    std::vector<VkBufferCopy> regions;
+    VkDeviceSize staging_offset = 0;
+    for (const auto& [offset, range] : _dirty_ranges) {
+        memcpy((uint8_t*) staging.data + staging_offset, range.data(), range.size());
+        regions.push_back({
+            .srcOffset = staging.offset + staging_offset,
+            .dstOffset = offset,
+            .size = range.size(),
+        });
+        staging_offset += range.size();
+    }
+    _transfer_context.flush_staging(staging, total_size);
 
-    vkFreeCommandBuffers(_device, _transfer_command_pool, 1, &command_buffer);
+    vkCmdCopyBuffer(command_buffer, staging.buffer, _buffer.buffer, (uint32_t) regions.size(), regions.data());
+    _dirty_ranges.clear();
 }
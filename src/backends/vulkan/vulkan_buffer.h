@@ -1,29 +1,39 @@
 #ifndef XGRAPHICS_VULKAN_BUFFER_H
 #define XGRAPHICS_VULKAN_BUFFER_H
 
+#include "vulkan_deletion_queue.h"
 #include "vulkan_device_def.h"
 #include "vulkan_memory_context.h"
+#include "vulkan_transfer_context.h"
+#include <map>
+#include <vector>
 #include <xgraphics/interfaces/graphics_buffer.h>
 
 struct vulkan_buffer_init {
     VkDevice device;
     buffer_usage_flags usage;
-    size_t size;
+    uint64_t size;
     const vulkan_device_def& def;
     vulkan_memory_context& memory_context;
-    VkCommandPool transfer_command_pool;
-    VkQueue transfer_queue;
+    vulkan_transfer_context& transfer_context;
+    vulkan_deletion_queue& deletion_queue;
+
+    // Persistently mapped host memory, written directly and never through staging
+    bool mapped = false;
 };
 
 class vulkan_buffer : public graphics_buffer {
     VkDevice _device;
     vulkan_memory_context& _memory_context;
-    VkBuffer _staging_buffer;
-    VkBuffer _buffer;
-    VkCommandPool _transfer_command_pool;
-    VkQueue _transfer_queue;
+    vulkan_buffer_allocation _buffer;
+    vulkan_transfer_context& _transfer_context;
+    vulkan_deletion_queue& _deletion_queue;
+    graphics_transfer_token _last_transfer;
+
+    // Deferred writes keep a host copy of each dirty range only, merged and keyed by their start offset
+    std::map<uint64_t, std::vector<uint8_t>> _dirty_ranges;
 
-    vulkan_buffer(const vulkan_buffer_init& init, VkBuffer staging_buffer, VkBuffer buffer);
+    vulkan_buffer(const vulkan_buffer_init& init, const vulkan_buffer_allocation& buffer);
 
   public:
     ~vulkan_buffer() override;
@@ -31,8 +41,28 @@ class vulkan_buffer : public graphics_buffer {
     static result::ptr<graphics_buffer> create(const vulkan_buffer_init& init);
 
     [[nodiscard]] VkBuffer buffer() const;
+    [[nodiscard]] bool host_visible() const;
+    [[nodiscard]] void* mapped_data() const;
+    void flush(uint64_t offset, uint64_t size) const;
+
+    using graphics_buffer::read_async;
+    using graphics_buffer::write;
+    using graphics_buffer::write_async;
+
+    void write(uint64_t offset, const void* data, uint64_t size) override;
+    graphics_transfer_token write_async(uint64_t offset, const void* data, uint64_t size) override;
+    void write_deferred(uint64_t offset, const void* data, uint64_t size) override;
+    std::unique_ptr<graphics_readback> read_async(uint64_t offset, uint64_t size) override;
+
+    // Used when the buffer is written as part of a batch
+    void track_transfer(graphics_transfer_token token);
+
+    // Copies newer data over the parts of dirty ranges that it overlaps, so that flushing them does not undo it
+    void update_dirty_ranges(uint64_t offset, const void* data, uint64_t size);
 
-    void write(const void* data, uint32_t size) override;
+    // Records a single copy of every dirty range, and clears them. Flushes larger than STREAM_CHUNK_SIZE are streamed
+    // in separate submissions instead.
+    void record_deferred_writes(VkCommandBuffer command_buffer);
 };
 
 #endif
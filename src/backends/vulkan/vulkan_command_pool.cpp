@@ -0,0 +1,59 @@
+#include "vulkan_command_pool.h"
+
+vulkan_command_pool::vulkan_command_pool(VkDevice device, const vulkan_sync_context& sync_context,
+                                         vulkan_deletion_queue& deletion_queue)
+    : _device(device), _sync_context(sync_context), _deletion_queue(deletion_queue) { }
+
+vulkan_command_pool::~vulkan_command_pool() {
+    // Command buffers of frames in flight may still be executing
+    _deletion_queue.release([device = _device, pools = _pools] {
+        for (auto pool : pools)
+            vkDestroyCommandPool(device, pool, nullptr);
+    });
+}
+
+result::ptr<vulkan_command_pool> vulkan_command_pool::create(VkDevice device, uint32_t queue_family,
+                                                             VkCommandBufferLevel level,
+                                                             const vulkan_sync_context& sync_context,
+                                                             vulkan_deletion_queue& deletion_queue) {
+    // Destroys the pools created so far on failure
+    auto command_pool =
+        std::unique_ptr<vulkan_command_pool>(new vulkan_command_pool(device, sync_context, deletion_queue));
+
+    // Command buffers are rerecorded every frame, and reset with their whole pool
+    VkCommandPoolCreateInfo pool_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = queue_family,
+    };
+
+    for (uint32_t i = 0; i < sync_context.frames_in_flight(); i++) {
+        VkCommandPool pool;
+        if (vkCreateCommandPool(device, &pool_info, nullptr, &pool) != VK_SUCCESS)
+            return result::err("Failed to create command pool");
+        command_pool->_pools.push_back(pool);
+
+        VkCommandBufferAllocateInfo alloc_info = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = pool,
+            .level = level,
+            .commandBufferCount = 1,
+        };
+
+        VkCommandBuffer command_buffer;
+        if (vkAllocateCommandBuffers(device, &alloc_info, &command_buffer) != VK_SUCCESS)
+            return result::err("Failed to allocate command buffers");
+        command_pool->_command_buffers.push_back(command_buffer);
+    }
+
+    return result::ok(command_pool.release());
+}
+
+VkCommandBuffer vulkan_command_pool::command_buffer() const {
+    return _command_buffers[_sync_context.current_frame()];
+}
+
+void vulkan_command_pool::reset() {
+    if (vkResetCommandPool(_device, _pools[_sync_context.current_frame()], 0) != VK_SUCCESS)
+        throw std::runtime_error("Failed to reset command pool");
+}
@@ -0,0 +1,37 @@
+#ifndef XGRAPHICS_VULKAN_COMMAND_POOL_H
+#define XGRAPHICS_VULKAN_COMMAND_POOL_H
+
+#include "vulkan_deletion_queue.h"
+#include "vulkan_sync_context.h"
+#include <memory>
+#include <result/result.h>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// A pool per frame in flight with a single command buffer each. Pools are externally synchronized, so every command
+// buffer owning its own pools lets separate threads record at the same time.
+class vulkan_command_pool {
+    VkDevice _device;
+    std::vector<VkCommandPool> _pools;
+    std::vector<VkCommandBuffer> _command_buffers;
+    const vulkan_sync_context& _sync_context;
+    vulkan_deletion_queue& _deletion_queue;
+
+    explicit vulkan_command_pool(VkDevice device, const vulkan_sync_context& sync_context,
+                                 vulkan_deletion_queue& deletion_queue);
+
+  public:
+    vulkan_command_pool(const vulkan_command_pool&) = delete;
+    ~vulkan_command_pool();
+
+    static result::ptr<vulkan_command_pool> create(VkDevice device, uint32_t queue_family, VkCommandBufferLevel level,
+                                                   const vulkan_sync_context& sync_context,
+                                                   vulkan_deletion_queue& deletion_queue);
+
+    [[nodiscard]] VkCommandBuffer command_buffer() const;
+
+    // Frees everything recorded into the pool of the current frame, which must have completed on the GPU
+    void reset();
+};
+
+#endif
@@ -0,0 +1,248 @@
+#include "vulkan_command_recorder.h"
+#include "vulkan_buffer.h"
+#include "vulkan_pipeline.h"
+#include "vulkan_resource_set.h"
+#include <algorithm>
+
+template <typename Interface>
+vulkan_command_recorder<Interface>::vulkan_command_recorder(std::unique_ptr<vulkan_command_pool> command_pool,
+                                                            const vulkan_device_def& def,
+                                                            const vulkan_device_functions& functions)
+    : _command_pool(std::move(command_pool)), _def(def), _functions(functions) {
+    _bound.vertex_buffers.resize(def.max_vertex_input_bindings);
+    _run_buffers.reserve(def.max_vertex_input_bindings);
+    _run_offsets.reserve(def.max_vertex_input_bindings);
+}
+
+template <typename Interface>
+void vulkan_command_recorder<Interface>::begin_recording(const VkCommandBufferBeginInfo& begin_info) {
+    _command_pool->reset();
+    reset_bound_state();
+    _stats = {};
+    if (vkBeginCommandBuffer(command_buffer(), &begin_info) != VK_SUCCESS)
+        throw std::runtime_error("Failed to begin recording command buffer");
+}
+
+template <typename Interface>
+void vulkan_command_recorder<Interface>::reset_bound_state() {
+    // Keeps the storage of the bindings
+    _bound.pipeline = VK_NULL_HANDLE;
+    std::fill(_bound.vertex_buffers.begin(), _bound.vertex_buffers.end(), vulkan_vertex_buffer_binding {});
+    _bound.index_buffer = {};
+    _bound.resource_layout = VK_NULL_HANDLE;
+    _bound.resource_sets.clear();
+}
+
+template <typename Interface>
+void vulkan_command_recorder<Interface>::set_viewport(const vulkan_swapchain& swapchain) {
+    VkViewport viewport = {
+        .x = 0.0f,
+        .y = (float) swapchain.extent().height,
+        .width = (float) swapchain.extent().width,
+        .height = -(float) swapchain.extent().height,
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f,
+    };
+    vkCmdSetViewport(command_buffer(), 0, 1, &viewport);
+
+    VkRect2D scissor = {
+        .offset = {0, 0},
+        .extent = swapchain.extent(),
+    };
+    vkCmdSetScissor(command_buffer(), 0, 1, &scissor);
+}
+
+template <typename Interface>
+VkCommandBuffer vulkan_command_recorder<Interface>::command_buffer() const {
+    return _command_pool->command_buffer();
+}
+
+template <typename Interface>
+void vulkan_command_recorder<Interface>::end() {
+    if (vkEndCommandBuffer(command_buffer()) != VK_SUCCESS) throw std::runtime_error("Failed to record command buffer");
+}
+
+template <typename Interface>
+void vulkan_command_recorder<Interface>::bind_pipeline(const graphics_pipeline& pipeline) {
+    const auto& native_pipeline = (const vulkan_pipeline&) pipeline;
+    if (_bound.pipeline == native_pipeline.pipeline()) {
+        _stats.elided_pipeline_binds++;
+        return;
+    }
+
+    vkCmdBindPipeline(command_buffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, native_pipeline.pipeline());
+    _bound.pipeline = native_pipeline.pipeline();
+    _stats.pipeline_binds++;
+}
+
+template <typename Interface>
+void vulkan_command_recorder<Interface>::bind_vertex_buffers(uint32_t first_index,
+                                                             std::span<const graphics_vertex_buffer_binding> buffers) {
+    if (first_index > _bound.vertex_buffers.size() || buffers.size() > _bound.vertex_buffers.size() - first_index)
+        throw std::runtime_error("Vertex buffer index is out of range");
+
+    // Unchanged indices split the changed ones into runs, which are each bound together
+    uint32_t run_start = first_index;
+    for (uint32_t i = 0; i < buffers.size(); i++) {
+        VkBuffer buffer = ((const vulkan_buffer*) buffers[i].buffer)->buffer();
+        auto& binding = _bound.vertex_buffers[first_index + i];
+        if (binding.buffer == buffer && binding.offset == buffers[i].offset) {
+            _stats.elided_vertex_buffer_binds++;
+            record_vertex_buffers(run_start);
+            run_start = first_index + i + 1;
+            continue;
+        }
+
+        binding = {buffer, buffers[i].offset};
+        _run_buffers.push_back(buffer);
+        _run_offsets.push_back(buffers[i].offset);
+    }
+    record_vertex_buffers(run_start);
+}
+
+template <typename Interface>
+void vulkan_command_recorder<Interface>::record_vertex_buffers(uint32_t first_index) {
+    if (_run_buffers.empty()) return;
+    vkCmdBindVertexBuffers(command_buffer(), first_index, (uint32_t) _run_buffers.size(), _run_buffers.data(),
+                           _run_offsets.data());
+    _stats.vertex_buffer_binds += _run_buffers.size();
+    _run_buffers.clear();
+    _run_offsets.clear();
+}
+
+template <typename Interface>
+void vulkan_command_recorder<Interface>::bind_index_buffer(const graphics_buffer& buffer, uint64_t offset,
+                                                           index_type type) {
+    const auto& native_buffer = (const vulkan_buffer&) buffer;
+    VkIndexType index_type;
+    switch (type) {
+        case index_type::uint_16:
+            index_type = VK_INDEX_TYPE_UINT16;
+            break;
+        case index_type::uint_32:
+            index_type = VK_INDEX_TYPE_UINT32;
+            break;
+        default:
+            throw std::runtime_error("Unsupported index type");
+    }
+
+    auto& binding = _bound.index_buffer;
+    if (binding.buffer == native_buffer.buffer() && binding.offset == offset && binding.type == index_type) {
+        _stats.elided_index_buffer_binds++;
+        return;
+    }
+
+    vkCmdBindIndexBuffer(command_buffer(), native_buffer.buffer(), offset, index_type);
+    binding = {native_buffer.buffer(), offset, index_type};
+    _stats.index_buffer_binds++;
+}
+
+template <typename Interface>
+void vulkan_command_recorder<Interface>::bind_resource_set(const graphics_resource_set& resource_set) {
+    const auto& native_resource_set = (const vulkan_resource_set&) resource_set;
+    uint32_t set_number = native_resource_set.ref()->backend_number;
+    VkDescriptorSet descriptor_set = native_resource_set.descriptor_set();
+
+    // Binding with another pipeline layout can disturb the other sets, so they are bound again
+    if (_bound.resource_layout != native_resource_set.pipeline_layout()) {
+        _bound.resource_layout = native_resource_set.pipeline_layout();
+        _bound.resource_sets.clear();
+    }
+    if (_bound.resource_sets.size() <= set_number) _bound.resource_sets.resize(set_number + 1, VK_NULL_HANDLE);
+
+    if (_bound.resource_sets[set_number] == descriptor_set) {
+        _stats.elided_resource_set_binds++;
+        return;
+    }
+
+    VkDescriptorSet sets[] = {descriptor_set};
+    vkCmdBindDescriptorSets(command_buffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, native_resource_set.pipeline_layout(),
+                            set_number, 1, sets, 0, nullptr);
+    _bound.resource_sets[set_number] = descriptor_set;
+    _stats.resource_set_binds++;
+}
+
+template <typename Interface>
+void vulkan_command_recorder<Interface>::draw(uint32_t vertex_start, uint32_t vertex_count, uint32_t instance_start,
+                                              uint32_t instance_count) {
+    vkCmdDraw(command_buffer(), vertex_count, instance_count, vertex_start, instance_start);
+    _stats.draws++;
+}
+
+template <typename Interface>
+void vulkan_command_recorder<Interface>::draw_indexed(uint32_t index_start, uint32_t index_count,
+                                                      uint32_t vertex_offset, uint32_t instance_start,
+                                                      uint32_t instance_count) {
+    vkCmdDrawIndexed(command_buffer(), index_count, instance_count, index_start, (int32_t) vertex_offset,
+                     instance_start);
+    _stats.draws++;
+}
+
+template <typename Interface>
+void vulkan_command_recorder<Interface>::draw_indirect(const graphics_buffer& buffer, uint64_t offset,
+                                                       uint32_t draw_count) {
+    const auto& native_buffer = (const vulkan_buffer&) buffer;
+    uint32_t stride = sizeof(graphics_draw_indirect_command);
+
+    // Split into commands of at most the device limit, which is a single record without multiple draws per command
+    uint32_t max_draws = _def.max_draw_indirect_count;
+    for (uint32_t first = 0; first < draw_count; first += max_draws) {
+        vkCmdDrawIndirect(command_buffer(), native_buffer.buffer(), offset + (uint64_t) first * stride,
+                          std::min(max_draws, draw_count - first), stride);
+    }
+    _stats.draws++;
+}
+
+template <typename Interface>
+void vulkan_command_recorder<Interface>::draw_indexed_indirect(const graphics_buffer& buffer, uint64_t offset,
+                                                               uint32_t draw_count) {
+    const auto& native_buffer = (const vulkan_buffer&) buffer;
+    uint32_t stride = sizeof(graphics_draw_indexed_indirect_command);
+    uint32_t max_draws = _def.max_draw_indirect_count;
+    for (uint32_t first = 0; first < draw_count; first += max_draws) {
+        vkCmdDrawIndexedIndirect(command_buffer(), native_buffer.buffer(), offset + (uint64_t) first * stride,
+                                 std::min(max_draws, draw_count - first), stride);
+    }
+    _stats.draws++;
+}
+
+template <typename Interface>
+void vulkan_command_recorder<Interface>::draw_indirect_count(const graphics_buffer& buffer, uint64_t offset,
+                                                             const graphics_buffer& count_buffer,
+                                                             uint64_t count_offset, uint32_t max_draw_count) {
+    if (!_functions.cmd_draw_indirect_count) throw std::runtime_error("Indirect draw counts are not supported");
+    if (max_draw_count > _def.max_draw_indirect_count)
+        throw std::runtime_error("Indirect draw count exceeds the device limit");
+
+    const auto& native_buffer = (const vulkan_buffer&) buffer;
+    const auto& native_count_buffer = (const vulkan_buffer&) count_buffer;
+    _functions.cmd_draw_indirect_count(command_buffer(), native_buffer.buffer(), offset, native_count_buffer.buffer(),
+                                       count_offset, max_draw_count, sizeof(graphics_draw_indirect_command));
+    _stats.draws++;
+}
+
+template <typename Interface>
+void vulkan_command_recorder<Interface>::draw_indexed_indirect_count(const graphics_buffer& buffer, uint64_t offset,
+                                                                     const graphics_buffer& count_buffer,
+                                                                     uint64_t count_offset,
+                                                                     uint32_t max_draw_count) {
+    if (!_functions.cmd_draw_indexed_indirect_count)
+        throw std::runtime_error("Indirect draw counts are not supported");
+    if (max_draw_count > _def.max_draw_indirect_count)
+        throw std::runtime_error("Indirect draw count exceeds the device limit");
+
+    const auto& native_buffer = (const vulkan_buffer&) buffer;
+    const auto& native_count_buffer = (const vulkan_buffer&) count_buffer;
+    _functions.cmd_draw_indexed_indirect_count(command_buffer(), native_buffer.buffer(), offset,
+                                               native_count_buffer.buffer(), count_offset, max_draw_count,
+                                               sizeof(graphics_draw_indexed_indirect_command));
+    _stats.draws++;
+}
+
+template <typename Interface>
+graphics_command_stats vulkan_command_recorder<Interface>::stats() const {
+    return _stats;
+}
+
+template class vulkan_command_recorder<graphics_command_buffer>;
+template class vulkan_command_recorder<graphics_secondary_command_buffer>;
@@ -0,0 +1,93 @@
+#ifndef XGRAPHICS_VULKAN_COMMAND_RECORDER_H
+#define XGRAPHICS_VULKAN_COMMAND_RECORDER_H
+
+#include "vulkan_command_pool.h"
+#include "vulkan_device_def.h"
+#include "vulkan_device_functions.h"
+#include "vulkan_swapchain.h"
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <xgraphics/interfaces/graphics_command_buffer.h>
+#include <xgraphics/interfaces/graphics_secondary_command_buffer.h>
+
+struct vulkan_vertex_buffer_binding {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+};
+
+struct vulkan_index_buffer_binding {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkIndexType type = VK_INDEX_TYPE_UINT16;
+};
+
+// The state bound in the command buffer, so that binding it again can be skipped. There is a vertex buffer binding for
+// every index the device supports, so binding never allocates.
+struct vulkan_bound_state {
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    std::vector<vulkan_vertex_buffer_binding> vertex_buffers;
+    vulkan_index_buffer_binding index_buffer;
+
+    // Descriptor sets by set number, which are only kept while they are bound with the same pipeline layout
+    VkPipelineLayout resource_layout = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSet> resource_sets;
+};
+
+// Records the commands shared by primary and secondary command buffers into the command buffer of the current frame
+template <typename Interface>
+class vulkan_command_recorder : public Interface {
+    std::unique_ptr<vulkan_command_pool> _command_pool;
+    const vulkan_device_def& _def;
+    const vulkan_device_functions& _functions;
+    vulkan_bound_state _bound;
+    graphics_command_stats _stats;
+
+    // Reused for every run of vertex buffers, and reserved up front for the most bindings the device supports
+    std::vector<VkBuffer> _run_buffers;
+    std::vector<VkDeviceSize> _run_offsets;
+
+    // Binds the run of consecutive indices that changed with a single command, and clears it
+    void record_vertex_buffers(uint32_t first_index);
+
+  protected:
+    explicit vulkan_command_recorder(std::unique_ptr<vulkan_command_pool> command_pool, const vulkan_device_def& def,
+                                     const vulkan_device_functions& functions);
+
+    // Resets the pool of the current frame and begins recording into it
+    void begin_recording(const VkCommandBufferBeginInfo& begin_info);
+
+    // Forgets the bound state, which is undefined after executing secondary command buffers
+    void reset_bound_state();
+
+    // The viewport is flipped to match the other backends, and isn't inherited by secondary command buffers
+    void set_viewport(const vulkan_swapchain& swapchain);
+
+  public:
+    using Interface::draw;
+    using Interface::draw_indexed;
+
+    [[nodiscard]] VkCommandBuffer command_buffer() const;
+
+    void end() override;
+    void bind_pipeline(const graphics_pipeline& pipeline) override;
+    void bind_vertex_buffers(uint32_t first_index, std::span<const graphics_vertex_buffer_binding> buffers) override;
+    void bind_index_buffer(const graphics_buffer& buffer, uint64_t offset, index_type type) override;
+    void bind_resource_set(const graphics_resource_set& resource_set) override;
+    void draw(uint32_t vertex_start, uint32_t vertex_count, uint32_t instance_start, uint32_t instance_count) override;
+    void draw_indexed(uint32_t index_start, uint32_t index_count, uint32_t vertex_offset, uint32_t instance_start,
+                      uint32_t instance_count) override;
+    void draw_indirect(const graphics_buffer& buffer, uint64_t offset, uint32_t draw_count) override;
+    void draw_indexed_indirect(const graphics_buffer& buffer, uint64_t offset, uint32_t draw_count) override;
+    void draw_indirect_count(const graphics_buffer& buffer, uint64_t offset, const graphics_buffer& count_buffer,
+                             uint64_t count_offset, uint32_t max_draw_count) override;
+    void draw_indexed_indirect_count(const graphics_buffer& buffer, uint64_t offset,
+                                     const graphics_buffer& count_buffer, uint64_t count_offset,
+                                     uint32_t max_draw_count) override;
+    [[nodiscard]] graphics_command_stats stats() const override;
+};
+
+extern template class vulkan_command_recorder<graphics_command_buffer>;
+extern template class vulkan_command_recorder<graphics_secondary_command_buffer>;
+
+#endif
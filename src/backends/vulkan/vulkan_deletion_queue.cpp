@@ -0,0 +1,40 @@
+#include "vulkan_deletion_queue.h"
+
+vulkan_deletion_queue::vulkan_deletion_queue(vulkan_sync_context& sync_context) : _sync_context(sync_context) { }
+
+result::ptr<vulkan_deletion_queue> vulkan_deletion_queue::create(vulkan_sync_context& sync_context) {
+    return result::ok(new vulkan_deletion_queue(sync_context));
+}
+
+void vulkan_deletion_queue::release(std::function<void()> destroy) {
+    std::lock_guard lock(_mutex);
+    _deletions.push_back({_sync_context.pending_frame_value(), std::move(destroy)});
+}
+
+void vulkan_deletion_queue::collect() {
+    uint64_t completed = _sync_context.completed_frame_value();
+
+    // Releases are queued in frame order, so the completed ones are at the front
+    std::deque<vulkan_deletion> completed_deletions;
+    {
+        std::lock_guard lock(_mutex);
+        while (!_deletions.empty() && _deletions.front().frame_value <= completed) {
+            completed_deletions.push_back(std::move(_deletions.front()));
+            _deletions.pop_front();
+        }
+    }
+
+    for (auto& deletion : completed_deletions)
+        deletion.destroy();
+}
+
+void vulkan_deletion_queue::flush() {
+    std::deque<vulkan_deletion> deletions;
+    {
+        std::lock_guard lock(_mutex);
+        deletions.swap(_deletions);
+    }
+
+    for (auto& deletion : deletions)
+        deletion.destroy();
+}
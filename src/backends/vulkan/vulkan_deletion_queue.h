@@ -0,0 +1,39 @@
+#ifndef XGRAPHICS_VULKAN_DELETION_QUEUE_H
+#define XGRAPHICS_VULKAN_DELETION_QUEUE_H
+
+#include "vulkan_sync_context.h"
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <result/result.h>
+
+struct vulkan_deletion {
+    uint64_t frame_value;
+    std::function<void()> destroy;
+};
+
+// Destroys released objects once every frame that could have used them has completed, instead of waiting for the
+// device to idle. A release is keyed to the value of the next frame submission, since the current frame may already
+// have recorded commands that use it. Releases can come from any thread.
+class vulkan_deletion_queue {
+    vulkan_sync_context& _sync_context;
+    std::deque<vulkan_deletion> _deletions;
+    std::mutex _mutex;
+
+    explicit vulkan_deletion_queue(vulkan_sync_context& sync_context);
+
+  public:
+    vulkan_deletion_queue(const vulkan_deletion_queue&) = delete;
+
+    static result::ptr<vulkan_deletion_queue> create(vulkan_sync_context& sync_context);
+
+    void release(std::function<void()> destroy);
+
+    // Destroys everything released before the last completed frame, called once per frame
+    void collect();
+
+    // Destroys everything, the device must be idle
+    void flush();
+};
+
+#endif
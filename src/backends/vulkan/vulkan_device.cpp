@@ -3,15 +3,21 @@
 #include "vulkan_buffer.h"
 #include "vulkan_command_buffer.h"
 #include "vulkan_device_def.h"
+#include "vulkan_geometry_arena.h"
 #include "vulkan_image.h"
 #include "vulkan_pipeline.h"
 #include "vulkan_render_pass.h"
 #include "vulkan_resource_layout.h"
 #include "vulkan_resource_set.h"
 #include "vulkan_sampler.h"
+#include "vulkan_secondary_command_buffer.h"
+#include "vulkan_semaphore.h"
 #include "vulkan_shader.h"
 #include "vulkan_swapchain.h"
+#include "vulkan_transient_allocator.h"
 #include "vulkan_uniform_buffer.h"
+#include "vulkan_utils.h"
+#include "vulkan_upload_batch.h"
 #include <set>
 
 const std::vector<const char*> vulkan_device::REQUIRED_EXTENSIONS = {
@@ -25,25 +31,32 @@ vulkan_device::vulkan_device(vulkan_device_init& init, vulkan_device_state& stat
       _surface(init.surface),
       _graphics_queue(state.graphics_queue),
       _present_queue(state.present_queue),
-      _transfer_queue(state.transfer_queue),
-      _command_pool(state.command_pool),
-      _transfer_command_pool(state.transfer_command_pool),
+      _functions(state.functions),
       _sync_context(std::move(state.sync_context)),
-      _memory_context(std::move(state.memory_context)) { }
+      _deletion_queue(std::move(state.deletion_queue)),
+      _memory_context(std::move(state.memory_context)),
+      _transfer_context(std::move(state.transfer_context)),
+      _transient_allocator(std::move(state.transient_allocator)) { }
 
 vulkan_device::~vulkan_device() {
-    vkDestroyCommandPool(_device, _command_pool, nullptr);
+    vkDeviceWaitIdle(_device);
+    _transient_allocator.reset();
+    _transfer_context.reset();
+    _deletion_queue->flush();
     vkDestroyDevice(_device, nullptr);
 }
 
 void vulkan_device::wait_for_frame() {
-    VkFence fence = _sync_context->gpu_wait_fence();
-    vkWaitForFences(_device, 1, &fence, VK_TRUE, UINT64_MAX);
-    vkResetFences(_device, 1, &fence);
+    _sync_context->wait_for_frame();
 }
 
 void vulkan_device::frame_changed(int current_frame) {
     _sync_context->set_current_frame(current_frame);
+    _frame_submitted = false;
+    _deletion_queue->collect();
+    _memory_context->advance_frame();
+    _transfer_context->begin_frame();
+    _transient_allocator->reset(current_frame);
 }
 
 result::ptr<graphics_device_def> vulkan_device::create_def(VkPhysicalDevice physical_device, VkSurfaceKHR surface) {
@@ -54,6 +67,8 @@ result::ptr<graphics_device_def> vulkan_device::create_def(VkPhysicalDevice phys
     auto device = std::make_unique<vulkan_device_def>();
     device->physical_device = physical_device;
     device->name = properties.deviceName;
+    device->min_uniform_buffer_offset_alignment = properties.limits.minUniformBufferOffsetAlignment;
+    device->max_vertex_input_bindings = properties.limits.maxVertexInputBindings;
     switch (properties.deviceType) {
         case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
             device->type = device_type::integrated;
@@ -99,9 +114,36 @@ result::ptr<graphics_device_def> vulkan_device::create_def(VkPhysicalDevice phys
         if (extension.extensionName == std::string("VK_KHR_portability_subset")) {
             device->required_extensions.push_back("VK_KHR_portability_subset");
         }
+
+        // The memory budget extension also depends on an instance extension, checked below
+        if (extension.extensionName == std::string(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME))
+            device->memory_budget_supported = true;
+
+        // Timeline semaphores also depend on an instance extension, checked below
+        if (extension.extensionName == std::string(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+            device->timeline_semaphore = true;
+
+        if (extension.extensionName == std::string(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)) {
+            device->draw_indirect_count = true;
+            device->required_extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+        }
     }
     if (!required_extensions.empty()) return result::err("Device does not support required extensions");
 
+    if (device->memory_budget_supported) {
+        device->memory_budget_supported = vulkan_utils::instance_extension_supported(
+            VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+        if (device->memory_budget_supported)
+            device->required_extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+
+    if (device->timeline_semaphore) {
+        device->timeline_semaphore = vulkan_utils::instance_extension_supported(
+            VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+        if (device->timeline_semaphore)
+            device->required_extensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+    }
+
     // Check swap chain support
     uint32_t format_count = 0;
     vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, surface, &format_count, nullptr);
@@ -116,6 +158,16 @@ result::ptr<graphics_device_def> vulkan_device::create_def(VkPhysicalDevice phys
     vkGetPhysicalDeviceFeatures(physical_device, &features);
     if (!features.samplerAnisotropy) return result::err("Device does not support anisotropic filtering");
 
+    // Compressed formats are optional, and only usable once their feature is enabled
+    device->texture_compression_bc = features.textureCompressionBC;
+    device->texture_compression_etc2 = features.textureCompressionETC2;
+    device->texture_compression_astc_ldr = features.textureCompressionASTC_LDR;
+
+    // Without multiple draws per indirect command, each record is drawn with its own command
+    device->multi_draw_indirect = features.multiDrawIndirect;
+    device->draw_indirect_first_instance = features.drawIndirectFirstInstance;
+    device->max_draw_indirect_count = features.multiDrawIndirect ? properties.limits.maxDrawIndirectCount : 1;
+
     return result::ok(device.release());
 }
 
@@ -124,7 +176,8 @@ result::ptr<graphics_device> vulkan_device::create(vulkan_device_init& init) {
     auto physical_device = native_def.physical_device;
 
     std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
-    std::set<uint32_t> unique_queue_families = {native_def.graphics_family.value(), native_def.present_family.value()};
+    std::set<uint32_t> unique_queue_families = {native_def.graphics_family.value(), native_def.present_family.value(),
+                                                native_def.transfer_family.value()};
 
     float queue_priority = 1.0f;
     for (uint32_t queue_family : unique_queue_families) {
@@ -138,7 +191,12 @@ result::ptr<graphics_device> vulkan_device::create(vulkan_device_init& init) {
     }
 
     VkPhysicalDeviceFeatures device_features = {
+        .multiDrawIndirect = native_def.multi_draw_indirect,
+        .drawIndirectFirstInstance = native_def.draw_indirect_first_instance,
         .samplerAnisotropy = VK_TRUE,
+        .textureCompressionETC2 = native_def.texture_compression_etc2,
+        .textureCompressionASTC_LDR = native_def.texture_compression_astc_ldr,
+        .textureCompressionBC = native_def.texture_compression_bc,
     };
 
     std::vector<const char*> extensions = {};
@@ -147,8 +205,14 @@ result::ptr<graphics_device> vulkan_device::create(vulkan_device_init& init) {
     for (const auto& extension : native_def.required_extensions)
         extensions.push_back(extension);
 
+    VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timeline_semaphore_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR,
+        .timelineSemaphore = VK_TRUE,
+    };
+
     VkDeviceCreateInfo create_info = {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+        .pNext = native_def.timeline_semaphore ? &timeline_semaphore_features : nullptr,
         .queueCreateInfoCount = (uint32_t) queue_create_infos.size(),
         .pQueueCreateInfos = queue_create_infos.data(),
         .enabledExtensionCount = (uint32_t) extensions.size(),
@@ -168,41 +232,44 @@ result::ptr<graphics_device> vulkan_device::create(vulkan_device_init& init) {
     vkGetDeviceQueue(device, native_def.present_family.value(), 0, &present_queue);
     vkGetDeviceQueue(device, native_def.transfer_family.value(), 0, &transfer_queue);
 
-    // Create command pool
-    VkCommandPoolCreateInfo pool_info = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-        .queueFamilyIndex = native_def.graphics_family.value(),
-    };
-    VkCommandPool command_pool;
-    if (vkCreateCommandPool(device, &pool_info, nullptr, &command_pool) != VK_SUCCESS)
-        return result::err("Failed to create command pool");
-
-    // Create transfer command pool
-    VkCommandPoolCreateInfo transfer_pool_info = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-        .queueFamilyIndex = native_def.transfer_family.value(),
-    };
-    VkCommandPool transfer_command_pool;
-    if (vkCreateCommandPool(device, &transfer_pool_info, nullptr, &transfer_command_pool) != VK_SUCCESS)
-        return result::err("Failed to create transfer command pool");
+    auto functions = vulkan_device_functions::load(device, native_def);
 
     // Create sync context
-    auto sync_context = GET_OR_FORWARD(vulkan_sync_context::create(device, init.config));
+    auto sync_context = GET_OR_FORWARD(vulkan_sync_context::create(device, native_def, functions, init.config));
+
+    // Create deletion queue
+    auto deletion_queue = GET_OR_FORWARD(vulkan_deletion_queue::create(*sync_context));
 
     // Create memory context
-    auto memory_context = GET_OR_FORWARD(vulkan_memory_context::create(init.instance, device, physical_device));
+    auto memory_context = GET_OR_FORWARD(vulkan_memory_context::create(init.instance, device, physical_device,
+                                                                       native_def.memory_budget_supported));
+
+    // Create transfer context
+    auto transfer_context = GET_OR_FORWARD(
+        vulkan_transfer_context::create(device, native_def, transfer_queue, graphics_queue, *sync_context,
+                                        *memory_context, *deletion_queue));
+
+    // Create transient allocator
+    vulkan_transient_allocator_init transient_init = {
+        .device = device,
+        .def = native_def,
+        .memory_context = *memory_context,
+        .transfer_context = *transfer_context,
+        .deletion_queue = *deletion_queue,
+        .frames_in_flight = (uint32_t) init.config.frames_in_flight,
+    };
+    auto transient_allocator = GET_OR_FORWARD(vulkan_transient_allocator::create(transient_init));
 
     vulkan_device_state state = {
         .device = device,
         .graphics_queue = graphics_queue,
         .present_queue = present_queue,
-        .transfer_queue = transfer_queue,
-        .command_pool = command_pool,
-        .transfer_command_pool = transfer_command_pool,
+        .functions = functions,
         .sync_context = std::move(sync_context),
+        .deletion_queue = std::move(deletion_queue),
         .memory_context = std::move(memory_context),
+        .transfer_context = std::move(transfer_context),
+        .transient_allocator = std::move(transient_allocator),
     };
 
     return result::ok(new vulkan_device(init, state));
@@ -215,6 +282,8 @@ result::ptr<graphics_swapchain> vulkan_device::create_swapchain(uint32_t width,
         .def = (const vulkan_device_def&) def(),
         .sync_context = *_sync_context,
         .memory_context = *_memory_context,
+        .deletion_queue = *_deletion_queue,
+        .config = config(),
         .width = width,
         .height = height,
     };
@@ -243,79 +312,184 @@ result::ptr<graphics_resource_set> vulkan_device::create_resource_set(const grap
         .layout = (const vulkan_resource_layout&) layout,
         .ref = ref,
         .sync_context = *_sync_context,
+        .deletion_queue = *_deletion_queue,
     };
 
     return vulkan_resource_set::create(init);
 }
 
 result::ptr<graphics_pipeline> vulkan_device::create_pipeline(const graphics_pipeline_init& init) {
-    return vulkan_pipeline::create(init, _device);
+    return vulkan_pipeline::create(init, _device, *_deletion_queue);
 }
 
-result::ptr<graphics_buffer> vulkan_device::create_buffer(buffer_usage_flags usage, uint32_t size) {
+result::ptr<graphics_buffer> vulkan_device::create_buffer(buffer_usage_flags usage, uint64_t size) {
     vulkan_buffer_init init = {
         .device = _device,
         .usage = usage,
         .size = size,
         .def = (const vulkan_device_def&) def(),
         .memory_context = *_memory_context,
-        .transfer_command_pool = _transfer_command_pool,
-        .transfer_queue = _transfer_queue,
+        .transfer_context = *_transfer_context,
+        .deletion_queue = *_deletion_queue,
     };
 
     return vulkan_buffer::create(init);
 }
 
-result::ptr<graphics_image> vulkan_device::create_image(uint32_t width, uint32_t height, graphics_image_format format) {
+bool vulkan_device::image_format_supported(graphics_image_format format) {
+    return vulkan_image::format_supported(((const vulkan_device_def&) def()).physical_device, format);
+}
+
+result::ptr<graphics_image> vulkan_device::create_image(const graphics_image_init& image_init) {
     vulkan_image_init init = {
-        .width = width,
-        .height = height,
-        .format = format,
+        .image = image_init,
         .device = _device,
         .def = (const vulkan_device_def*) &def(),
         .memory_context = _memory_context.get(),
-        .transfer_command_pool = _transfer_command_pool,
-        .transfer_queue = _transfer_queue,
+        .transfer_context = _transfer_context.get(),
+        .deletion_queue = _deletion_queue.get(),
     };
 
     return vulkan_image::create(init);
 }
 
 result::ptr<graphics_sampler> vulkan_device::create_sampler(const graphics_sampler_init& init) {
-    return vulkan_sampler::create(init, _device);
+    return vulkan_sampler::create(init, _device, *_deletion_queue);
 }
 
 result::ptr<graphics_uniform_buffer> vulkan_device::create_uniform_buffer(const shader_variable_type& type) {
-    return vulkan_uniform_buffer::create(type, _device, *_sync_context, *_memory_context);
+    return vulkan_uniform_buffer::create(type, _device, *_sync_context, *_memory_context, *_deletion_queue);
 }
 
 result::ptr<graphics_command_buffer> vulkan_device::create_command_buffer() {
-    return vulkan_command_buffer::create(_device, _command_pool, *_sync_context);
+    const auto& native_def = (const vulkan_device_def&) def();
+    return vulkan_command_buffer::create(_device, native_def, _functions, *_sync_context, *_deletion_queue);
 }
 
-void vulkan_device::submit_command_buffer(const graphics_command_buffer& command_buffer) {
-    const auto& native_command_buffer = (const vulkan_command_buffer&) command_buffer;
+result::ptr<graphics_secondary_command_buffer> vulkan_device::create_secondary_command_buffer() {
+    const auto& native_def = (const vulkan_device_def&) def();
+    return vulkan_secondary_command_buffer::create(_device, native_def, _functions, *_sync_context,
+                                                   *_deletion_queue);
+}
 
-    VkPipelineStageFlags wait_stages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+result::ptr<graphics_upload_batch> vulkan_device::create_upload_batch() {
+    return vulkan_upload_batch::create(*_transfer_context);
+}
 
-    VkCommandBuffer vk_buffer = native_command_buffer.command_buffer();
-    VkFence fence = _sync_context->gpu_wait_fence();
-    VkSemaphore image_available_semaphore = _sync_context->image_available_semaphore();
-    VkSemaphore render_finished_semaphore = _sync_context->render_finished_semaphore();
+graphics_transient_allocation vulkan_device::allocate_transient(buffer_usage_flags usage, uint64_t size) {
+    return _transient_allocator->allocate(usage, size);
+}
 
-    VkSubmitInfo submit_info = {
-        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .waitSemaphoreCount = 1,
-        .pWaitSemaphores = &image_available_semaphore,
-        .pWaitDstStageMask = wait_stages,
-        .commandBufferCount = 1,
-        .pCommandBuffers = &vk_buffer,
-        .signalSemaphoreCount = 1,
-        .pSignalSemaphores = &render_finished_semaphore,
+result::ptr<graphics_geometry_arena> vulkan_device::create_geometry_arena(buffer_usage_flags usage,
+                                                                          uint64_t block_size) {
+    vulkan_geometry_arena_init init = {
+        .device = _device,
+        .usage = usage,
+        .block_size = block_size,
+        .def = (const vulkan_device_def&) def(),
+        .memory_context = *_memory_context,
+        .transfer_context = *_transfer_context,
+        .deletion_queue = *_deletion_queue,
     };
 
-    if (vkQueueSubmit(_graphics_queue, 1, &submit_info, fence) != VK_SUCCESS)
-        throw std::runtime_error("Failed to submit command buffer");
+    return vulkan_geometry_arena::create(init);
+}
+
+result::ptr<graphics_semaphore> vulkan_device::create_semaphore() {
+    return vulkan_semaphore::create(_device);
+}
+
+void vulkan_device::submit(const std::vector<graphics_submission>& submissions) {
+    if (_frame_submitted) throw std::runtime_error("Frame has already been submitted");
+    _frame_submitted = true;
+
+    // Upload deferred buffer writes and transient data before the command buffers can read them
+    _transfer_context->flush_deferred();
+    _transient_allocator->flush();
+
+    // Batches are filled before any submit info points into them
+    std::vector<vulkan_submit_batch> batches;
+
+    // Every batch waits for the transfers submitted since the last frame, as a wait only orders its own batch. Binary
+    // semaphores can only be waited on once, so with several batches an empty batch waits for the transfers instead,
+    // and signals a relay semaphore for each of the others.
+    auto transfer_semaphores = _transfer_context->take_wait_semaphores();
+    // Uploads can be read by any stage, including vertex and compute shaders and later copies on the graphics queue
+    VkPipelineStageFlags transfer_stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    if (!transfer_semaphores.empty() && submissions.size() > 1) {
+        vulkan_submit_batch relay_batch = {.command_buffer = VK_NULL_HANDLE};
+        relay_batch.wait_semaphores = transfer_semaphores;
+        relay_batch.wait_stages.assign(transfer_semaphores.size(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+        relay_batch.signal_semaphores = _sync_context->relay_semaphores((uint32_t) submissions.size());
+        transfer_semaphores = relay_batch.signal_semaphores;
+        batches.push_back(std::move(relay_batch));
+    }
+
+    for (size_t i = 0; i < submissions.size(); i++) {
+        const auto& submission = submissions[i];
+        auto& batch = batches.emplace_back();
+        batch.command_buffer = ((const vulkan_command_buffer*) submission.command_buffer)->command_buffer();
+
+        if (submissions.size() == 1) {
+            for (auto semaphore : transfer_semaphores) {
+                batch.wait_semaphores.push_back(semaphore);
+                batch.wait_stages.push_back(transfer_stages);
+            }
+        } else if (!transfer_semaphores.empty()) {
+            batch.wait_semaphores.push_back(transfer_semaphores[i]);
+            batch.wait_stages.push_back(transfer_stages);
+        }
+
+        if (submission.swapchain) {
+            batch.wait_semaphores.push_back(_sync_context->image_available_semaphore());
+            batch.wait_stages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+            batch.signal_semaphores.push_back(_sync_context->render_finished_semaphore());
+        }
+
+        for (const auto* semaphore : submission.wait_semaphores) {
+            batch.wait_semaphores.push_back(((const vulkan_semaphore*) semaphore)->semaphore());
+            batch.wait_stages.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+        }
+        for (const auto* semaphore : submission.signal_semaphores)
+            batch.signal_semaphores.push_back(((const vulkan_semaphore*) semaphore)->semaphore());
+    }
+
+    // The last batch signals the frame value, which also covers the work submitted before it
+    uint64_t frame_value = _sync_context->signal_frame();
+    std::vector<uint64_t> signal_values;
+    VkTimelineSemaphoreSubmitInfoKHR timeline_info = {
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,
+    };
+    if (_sync_context->timeline()) {
+        if (batches.empty()) batches.push_back({.command_buffer = VK_NULL_HANDLE});
+        auto& batch = batches.back();
+        batch.signal_semaphores.push_back(_sync_context->frame_timeline());
+
+        // Values of binary semaphores are ignored
+        signal_values.resize(batch.signal_semaphores.size());
+        signal_values.back() = frame_value;
+        timeline_info.signalSemaphoreValueCount = (uint32_t) signal_values.size();
+        timeline_info.pSignalSemaphoreValues = signal_values.data();
+    }
+
+    std::vector<VkSubmitInfo> submit_infos;
+    for (const auto& batch : batches) {
+        submit_infos.push_back({
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext = &batch == &batches.back() && _sync_context->timeline() ? &timeline_info : nullptr,
+            .waitSemaphoreCount = (uint32_t) batch.wait_semaphores.size(),
+            .pWaitSemaphores = batch.wait_semaphores.data(),
+            .pWaitDstStageMask = batch.wait_stages.data(),
+            .commandBufferCount = batch.command_buffer ? 1u : 0u,
+            .pCommandBuffers = &batch.command_buffer,
+            .signalSemaphoreCount = (uint32_t) batch.signal_semaphores.size(),
+            .pSignalSemaphores = batch.signal_semaphores.data(),
+        });
+    }
+
+    VkFence fence = _sync_context->gpu_wait_fence();
+    if (vkQueueSubmit(_graphics_queue, (uint32_t) submit_infos.size(), submit_infos.data(), fence) != VK_SUCCESS)
+        throw std::runtime_error("Failed to submit command buffers");
 }
 
 void vulkan_device::present(graphics_swapchain& swapchain) {
@@ -336,3 +510,15 @@ void vulkan_device::present(graphics_swapchain& swapchain) {
     VkResult result = vkQueuePresentKHR(_present_queue, &present_info);
     native_swapchain.recreate_if_needed(result);
 }
+
+graphics_memory_stats vulkan_device::memory_stats() {
+    return _memory_context->stats();
+}
+
+bool vulkan_device::transfer_complete(graphics_transfer_token token) {
+    return _transfer_context->complete(token);
+}
+
+void vulkan_device::wait_for_transfer(graphics_transfer_token token) {
+    _transfer_context->wait(token);
+}
@@ -1,8 +1,12 @@
 #ifndef XGRAPHICS_VULKAN_DEVICE_H
 #define XGRAPHICS_VULKAN_DEVICE_H
 
+#include "vulkan_deletion_queue.h"
+#include "vulkan_device_functions.h"
 #include "vulkan_memory_context.h"
 #include "vulkan_sync_context.h"
+#include "vulkan_transfer_context.h"
+#include "vulkan_transient_allocator.h"
 #include <result/result.h>
 #include <vector>
 #include <vulkan/vulkan.h>
@@ -19,11 +23,20 @@ struct vulkan_device_state {
     VkDevice device;
     VkQueue graphics_queue;
     VkQueue present_queue;
-    VkQueue transfer_queue;
-    VkCommandPool command_pool;
-    VkCommandPool transfer_command_pool;
+    vulkan_device_functions functions;
     std::unique_ptr<vulkan_sync_context> sync_context;
+    std::unique_ptr<vulkan_deletion_queue> deletion_queue;
     std::unique_ptr<vulkan_memory_context> memory_context;
+    std::unique_ptr<vulkan_transfer_context> transfer_context;
+    std::unique_ptr<vulkan_transient_allocator> transient_allocator;
+};
+
+// A submit info of a batch points into it, so it has to stay in place until the submit
+struct vulkan_submit_batch {
+    VkCommandBuffer command_buffer;
+    std::vector<VkSemaphore> wait_semaphores;
+    std::vector<VkPipelineStageFlags> wait_stages;
+    std::vector<VkSemaphore> signal_semaphores;
 };
 
 class vulkan_device : public graphics_device {
@@ -31,11 +44,13 @@ class vulkan_device : public graphics_device {
     VkSurfaceKHR _surface;
     VkQueue _graphics_queue;
     VkQueue _present_queue;
-    VkQueue _transfer_queue;
-    VkCommandPool _command_pool;
-    VkCommandPool _transfer_command_pool;
+    vulkan_device_functions _functions;
     std::unique_ptr<vulkan_sync_context> _sync_context;
+    std::unique_ptr<vulkan_deletion_queue> _deletion_queue;
     std::unique_ptr<vulkan_memory_context> _memory_context;
+    std::unique_ptr<vulkan_transfer_context> _transfer_context;
+    std::unique_ptr<vulkan_transient_allocator> _transient_allocator;
+    bool _frame_submitted = false;
 
     const static std::vector<const char*> REQUIRED_EXTENSIONS;
 
@@ -59,14 +74,28 @@ class vulkan_device : public graphics_device {
     result::ptr<graphics_resource_set> create_resource_set(const graphics_resource_layout& layout,
                                                            resource_set_ref ref) override;
     result::ptr<graphics_pipeline> create_pipeline(const graphics_pipeline_init& init) override;
-    result::ptr<graphics_buffer> create_buffer(buffer_usage_flags usage, uint32_t size) override;
-    result::ptr<graphics_image> create_image(uint32_t width, uint32_t height, graphics_image_format format) override;
+    using graphics_device::create_buffer;
+    using graphics_device::create_image;
+
+    result::ptr<graphics_buffer> create_buffer(buffer_usage_flags usage, uint64_t size) override;
+    result::ptr<graphics_image> create_image(const graphics_image_init& init) override;
+    bool image_format_supported(graphics_image_format format) override;
     result::ptr<graphics_sampler> create_sampler(const graphics_sampler_init& init) override;
     result::ptr<graphics_uniform_buffer> create_uniform_buffer(const shader_variable_type& type) override;
     result::ptr<graphics_command_buffer> create_command_buffer() override;
+    result::ptr<graphics_secondary_command_buffer> create_secondary_command_buffer() override;
+    result::ptr<graphics_upload_batch> create_upload_batch() override;
+    graphics_transient_allocation allocate_transient(buffer_usage_flags usage, uint64_t size) override;
+    result::ptr<graphics_geometry_arena> create_geometry_arena(buffer_usage_flags usage, uint64_t block_size) override;
 
-    void submit_command_buffer(const graphics_command_buffer& command_buffer) override;
+    result::ptr<graphics_semaphore> create_semaphore() override;
+    void submit(const std::vector<graphics_submission>& submissions) override;
     void present(graphics_swapchain& swapchain) override;
+
+    graphics_memory_stats memory_stats() override;
+
+    bool transfer_complete(graphics_transfer_token token) override;
+    void wait_for_transfer(graphics_transfer_token token) override;
 };
 
 #endif
\ No newline at end of file
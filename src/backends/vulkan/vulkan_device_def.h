@@ -12,6 +12,16 @@ struct vulkan_device_def : public graphics_device_def {
     std::optional<uint32_t> present_family;
     std::optional<uint32_t> transfer_family;
     std::vector<const char*> required_extensions;
+    bool memory_budget_supported = false;
+    VkDeviceSize min_uniform_buffer_offset_alignment = 1;
+    uint32_t max_vertex_input_bindings = 16;
+    bool texture_compression_bc = false;
+    bool texture_compression_etc2 = false;
+    bool texture_compression_astc_ldr = false;
+    bool multi_draw_indirect = false;
+    bool draw_indirect_first_instance = false;
+    uint32_t max_draw_indirect_count = 1;
+    bool timeline_semaphore = false;
 };
 
 #endif
@@ -0,0 +1,17 @@
+#include "vulkan_device_functions.h"
+
+vulkan_device_functions vulkan_device_functions::load(VkDevice device, const vulkan_device_def& def) {
+    vulkan_device_functions functions;
+    if (def.draw_indirect_count) {
+        functions.cmd_draw_indirect_count =
+            (PFN_vkCmdDrawIndirectCountKHR) vkGetDeviceProcAddr(device, "vkCmdDrawIndirectCountKHR");
+        functions.cmd_draw_indexed_indirect_count =
+            (PFN_vkCmdDrawIndexedIndirectCountKHR) vkGetDeviceProcAddr(device, "vkCmdDrawIndexedIndirectCountKHR");
+    }
+    if (def.timeline_semaphore) {
+        functions.wait_semaphores = (PFN_vkWaitSemaphoresKHR) vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR");
+        functions.get_semaphore_counter_value =
+            (PFN_vkGetSemaphoreCounterValueKHR) vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR");
+    }
+    return functions;
+}
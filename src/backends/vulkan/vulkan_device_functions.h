@@ -0,0 +1,17 @@
+#ifndef XGRAPHICS_VULKAN_DEVICE_FUNCTIONS_H
+#define XGRAPHICS_VULKAN_DEVICE_FUNCTIONS_H
+
+#include "vulkan_device_def.h"
+#include <vulkan/vulkan.h>
+
+// Commands of device extensions, which the loader doesn't export. They are null when their extension isn't enabled.
+struct vulkan_device_functions {
+    PFN_vkCmdDrawIndirectCountKHR cmd_draw_indirect_count = nullptr;
+    PFN_vkCmdDrawIndexedIndirectCountKHR cmd_draw_indexed_indirect_count = nullptr;
+    PFN_vkWaitSemaphoresKHR wait_semaphores = nullptr;
+    PFN_vkGetSemaphoreCounterValueKHR get_semaphore_counter_value = nullptr;
+
+    static vulkan_device_functions load(VkDevice device, const vulkan_device_def& def);
+};
+
+#endif
@@ -0,0 +1,51 @@
+#include "vulkan_geometry_arena.h"
+
+#include "vulkan_buffer.h"
+
+vulkan_geometry_arena::vulkan_geometry_arena(const vulkan_geometry_arena_init& init)
+    : graphics_geometry_arena(init.usage, init.block_size),
+      _device(init.device),
+      _def(init.def),
+      _memory_context(init.memory_context),
+      _transfer_context(init.transfer_context),
+      _deletion_queue(init.deletion_queue) { }
+
+result::ptr<graphics_geometry_arena> vulkan_geometry_arena::create(const vulkan_geometry_arena_init& init) {
+    return result::ok(new vulkan_geometry_arena(init));
+}
+
+result::ptr<graphics_buffer> vulkan_geometry_arena::create_block(buffer_usage_flags usage, uint64_t size) {
+    vulkan_buffer_init init = {
+        .device = _device,
+        .usage = usage,
+        .size = size,
+        .def = _def,
+        .memory_context = _memory_context,
+        .transfer_context = _transfer_context,
+        .deletion_queue = _deletion_queue,
+    };
+
+    return vulkan_buffer::create(init);
+}
+
+void vulkan_geometry_arena::copy(const std::vector<graphics_geometry_copy>& copies) {
+    // Deferred writes still waiting in the old blocks would otherwise be lost
+    _transfer_context.flush_deferred();
+
+    if (!copies.empty()) {
+        VkCommandBuffer command_buffer = _transfer_context.begin();
+        for (const auto& copy : copies) {
+            VkBufferCopy region = {
+                .srcOffset = copy.src_offset,
+                .dstOffset = copy.dst_offset,
+                .size = copy.size,
+            };
+            vkCmdCopyBuffer(command_buffer, ((const vulkan_buffer*) copy.src)->buffer(),
+                            ((const vulkan_buffer*) copy.dst)->buffer(), 1, &region);
+        }
+
+        _transfer_context.wait(_transfer_context.submit(command_buffer));
+    }
+
+    // Frames in flight may still draw from the old blocks, which the deletion queue keeps alive until they complete
+}
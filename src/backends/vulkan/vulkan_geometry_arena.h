@@ -0,0 +1,39 @@
+#ifndef XGRAPHICS_VULKAN_GEOMETRY_ARENA_H
+#define XGRAPHICS_VULKAN_GEOMETRY_ARENA_H
+
+#include "vulkan_deletion_queue.h"
+#include "vulkan_device_def.h"
+#include "vulkan_memory_context.h"
+#include "vulkan_transfer_context.h"
+#include <result/result.h>
+#include <vulkan/vulkan.h>
+#include <xgraphics/interfaces/graphics_geometry_arena.h>
+
+struct vulkan_geometry_arena_init {
+    VkDevice device;
+    buffer_usage_flags usage;
+    uint64_t block_size;
+    const vulkan_device_def& def;
+    vulkan_memory_context& memory_context;
+    vulkan_transfer_context& transfer_context;
+    vulkan_deletion_queue& deletion_queue;
+};
+
+class vulkan_geometry_arena : public graphics_geometry_arena {
+    VkDevice _device;
+    const vulkan_device_def& _def;
+    vulkan_memory_context& _memory_context;
+    vulkan_transfer_context& _transfer_context;
+    vulkan_deletion_queue& _deletion_queue;
+
+    explicit vulkan_geometry_arena(const vulkan_geometry_arena_init& init);
+
+  protected:
+    result::ptr<graphics_buffer> create_block(buffer_usage_flags usage, uint64_t size) override;
+    void copy(const std::vector<graphics_geometry_copy>& copies) override;
+
+  public:
+    static result::ptr<graphics_geometry_arena> create(const vulkan_geometry_arena_init& init);
+};
+
+#endif
@@ -1,85 +1,107 @@
 #include "vulkan_image.h"
+#include "vulkan_readback.h"
+#include <set>
 
-vulkan_image::vulkan_image(const vulkan_image_init& init, VkBuffer staging_buffer, VkImage image,
+vulkan_image::vulkan_image(const vulkan_image_init& init, const vulkan_image_allocation& image,
                            VkImageView image_view)
-    : graphics_image(init.width, init.height, init.format),
+    : graphics_image(init.image),
       _device(init.device),
       _memory_context(init.memory_context),
-      _transfer_command_pool(init.transfer_command_pool),
-      _transfer_queue(init.transfer_queue),
-      _staging_buffer(staging_buffer),
+      _deletion_queue(init.deletion_queue),
+      _transfer_context(init.transfer_context),
       _image(image),
-      _image_view(image_view) { }
+      _image_view(image_view),
+      _layouts(mip_levels() * layers(), VK_IMAGE_LAYOUT_UNDEFINED) { }
 
 vulkan_image::~vulkan_image() {
-    _memory_context->destroy_buffer(_staging_buffer);
-    _memory_context->destroy_image(_image);
+    if (!_pending_regions.empty()) _transfer_context->cancel_deferred(this);
+    _transfer_context->wait(_last_transfer);
+    _deletion_queue->release([device = _device, memory_context = _memory_context, image = _image,
+                              image_view = _image_view] {
+        vkDestroyImageView(device, image_view, nullptr);
+        memory_context->destroy_image(image);
+    });
 }
 
 result::ptr<graphics_image> vulkan_image::create(const vulkan_image_init& init) {
-    int channels = 0;
-    VkFormat format = VK_FORMAT_UNDEFINED;
+    if (!graphics_image::valid(init.image)) return result::err("Image size does not fit its type");
+    if (!format_supported(init.def->physical_device, init.image.format))
+        return result::err("Image format is not supported by the device");
+    if (init.image.mipmaps && graphics_image::compressed(init.image.format))
+        return result::err("Mipmaps cannot be generated for compressed image formats");
 
-    switch (init.format) {
-        case graphics_image_format::rgba_8_srgb:
-            channels = 4;
-            format = VK_FORMAT_R8G8B8A8_SRGB;
+    VkFormat format = vk_format(init.image.format);
+
+    VkImageType image_type = VK_IMAGE_TYPE_2D;
+    VkImageViewType view_type = VK_IMAGE_VIEW_TYPE_2D;
+    VkImageCreateFlags flags = 0;
+    uint32_t layers = 1;
+    uint32_t depth = 1;
+    switch (init.image.type) {
+        case graphics_image_type::image_2d:
             break;
-        case graphics_image_format::rgba_8_unorm:
-            channels = 4;
-            format = VK_FORMAT_R8G8B8A8_UNORM;
+        case graphics_image_type::image_2d_array:
+            view_type = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+            layers = std::max(init.image.layers, 1u);
+            break;
+        case graphics_image_type::cube:
+            view_type = VK_IMAGE_VIEW_TYPE_CUBE;
+            flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+            layers = 6;
+            break;
+        case graphics_image_type::image_3d:
+            image_type = VK_IMAGE_TYPE_3D;
+            view_type = VK_IMAGE_VIEW_TYPE_3D;
+            depth = std::max(init.image.depth, 1u);
             break;
     }
 
-    VkDeviceSize image_size = init.width * init.height * channels;
-    VkBufferCreateInfo staging_buffer_info = {
-        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-        .size = image_size,
-        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-        .queueFamilyIndexCount = 0,
-        .pQueueFamilyIndices = nullptr,
-    };
+    uint32_t mip_levels = std::max(init.image.mip_levels, 1u);
+    VkImageUsageFlags usage =
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (init.image.mipmaps) {
+        // Levels are blitted from each other with linear filtering
+        VkFormatProperties format_properties;
+        vkGetPhysicalDeviceFormatProperties(init.def->physical_device, format, &format_properties);
+        VkFormatFeatureFlags blit_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                                             VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        if ((format_properties.optimalTilingFeatures & blit_features) != blit_features)
+            return result::err("Image format does not support linear blits for mipmap generation");
 
-    if (init.def->transfer_family != init.def->graphics_family) {
-        uint32_t queue_family_indices[] = {init.def->transfer_family.value(), init.def->graphics_family.value()};
-        staging_buffer_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
-        staging_buffer_info.queueFamilyIndexCount = 2;
-        staging_buffer_info.pQueueFamilyIndices = queue_family_indices;
+        mip_levels = graphics_image::mip_level_count(init.image.width, init.image.height, depth);
     }
 
-    auto staging_buffer = GET_OR_FORWARD(init.memory_context->create_staging_buffer(staging_buffer_info));
-
     VkImageCreateInfo image_info = {
         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-        .imageType = VK_IMAGE_TYPE_2D,
+        .flags = flags,
+        .imageType = image_type,
         .format = format,
-        .extent = {.width = init.width, .height = init.height, .depth = 1},
-        .mipLevels = 1,
-        .arrayLayers = 1,
+        .extent = {.width = init.image.width, .height = init.image.height, .depth = depth},
+        .mipLevels = mip_levels,
+        .arrayLayers = layers,
         .samples = VK_SAMPLE_COUNT_1_BIT,
         .tiling = VK_IMAGE_TILING_OPTIMAL,
-        .usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .usage = usage,
         .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
         .queueFamilyIndexCount = 0,
         .pQueueFamilyIndices = nullptr,
         .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
     };
 
-    auto image = GET_OR_FORWARD(init.memory_context->create_gpu_image(image_info));
+    auto image = GET_OR_FORWARD(init.memory_context->create_gpu_image(image_info, vulkan_memory_kind::image));
 
     VkImageViewCreateInfo image_view_info = {
         .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-        .image = image,
-        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .image = image.image,
+        .viewType = view_type,
         .format = format,
         .subresourceRange =
             {
                 .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
                 .baseMipLevel = 0,
-                .levelCount = 1,
+                .levelCount = mip_levels,
                 .baseArrayLayer = 0,
-                .layerCount = 1,
+                .layerCount = layers,
             },
     };
 
@@ -87,103 +109,396 @@ result::ptr<graphics_image> vulkan_image::create(const vulkan_image_init& init)
     if (vkCreateImageView(init.device, &image_view_info, nullptr, &image_view) != VK_SUCCESS)
         return result::err("failed to create image view!");
 
-    return result::ok(new vulkan_image(init, staging_buffer, image, image_view));
+    return result::ok(new vulkan_image(init, image, image_view));
 }
 
-void vulkan_image::write(const void* data, uint32_t size) {
-    // Map and copy to staging buffer
-    void* mapped_data = _memory_context->map_buffer(_staging_buffer);
-    memcpy(mapped_data, data, size);
-    _memory_context->unmap_buffer(_staging_buffer);
+void vulkan_image::write(const void* data, uint64_t size) {
+    _transfer_context->wait(write_async(data, size));
+}
 
-    // Create transfer command buffer
-    VkCommandBufferAllocateInfo alloc_info = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-        .commandPool = _transfer_command_pool,
-        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandBufferCount = 1,
-    };
+graphics_transfer_token vulkan_image::write_async(const void* data, uint64_t size) {
+    return write_level_async(0, data, size);
+}
 
-    VkCommandBuffer command_buffer;
-    if (vkAllocateCommandBuffers(_device, &alloc_info, &command_buffer) != VK_SUCCESS)
-        throw std::runtime_error("Failed to allocate command buffer");
+void vulkan_image::write_level(uint32_t mip_level, const void* data, uint64_t size) {
+    _transfer_context->wait(write_level_async(mip_level, data, size));
+}
 
-    // Begin transfer command buffer
-    VkCommandBufferBeginInfo begin_info = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-    };
+graphics_transfer_token vulkan_image::write_level_async(uint32_t mip_level, const void* data, uint64_t size) {
+    return write_subresource_async(mip_level, ALL_LAYERS, data, size);
+}
 
-    if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS)
-        throw std::runtime_error("Failed to begin command buffer");
+void vulkan_image::write_layer(uint32_t layer, uint32_t mip_level, const void* data, uint64_t size) {
+    _transfer_context->wait(write_layer_async(layer, mip_level, data, size));
+}
+
+graphics_transfer_token vulkan_image::write_layer_async(uint32_t layer, uint32_t mip_level, const void* data,
+                                                        uint64_t size) {
+    if (layer >= layers()) throw std::runtime_error("Image layer is out of range");
+    return write_subresource_async(mip_level, layer, data, size);
+}
+
+graphics_transfer_token vulkan_image::write_subresource_async(uint32_t mip_level, uint32_t layer, const void* data,
+                                                              uint64_t size) {
+    if (immutable()) throw std::runtime_error("Cannot write to an immutable image");
+    if (mip_level >= mip_levels()) throw std::runtime_error("Image mip level is out of range");
+    if (generates_mipmaps() && mip_level > 0) throw std::runtime_error("Cannot write to a generated mip level");
+    if (size != level_size(mip_level) * (layer == ALL_LAYERS ? layers() : 1))
+        throw std::runtime_error("Image write size does not match the level");
+
+    // Copy to staging memory
+    auto staging = _transfer_context->allocate_staging(size);
+    memcpy(staging.data, data, size);
+    _transfer_context->flush_staging(staging, size);
+
+    // Blits need a graphics capable queue
+    bool mipmapped = generates_mipmaps();
+    VkCommandBuffer command_buffer = mipmapped ? _transfer_context->begin_graphics() : _transfer_context->begin();
 
     // Transition image to transfer destination
+    VkImageMemoryBarrier barrier = transfer_dst_barrier(mip_level, VK_IMAGE_LAYOUT_UNDEFINED, layer);
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0,
+                         nullptr, 0, nullptr, 1, &barrier);
+
+    // Copy buffer to image
+    VkBufferImageCopy region = copy_region(staging.offset, mip_level, layer);
+    vkCmdCopyBufferToImage(command_buffer, staging.buffer, _image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+                           &region);
+
+    if (mipmapped) {
+        record_mipmaps(command_buffer, layer);
+        track_write(mip_level, layer);
+        _last_transfer = _transfer_context->submit_graphics(command_buffer);
+        return _last_transfer;
+    }
+
+    // Transition image to shader read
+    barrier = shader_read_barrier(mip_level, layer);
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0,
+                         nullptr, 0, nullptr, 1, &barrier);
+
+    track_write(mip_level, layer);
+    _last_transfer = _transfer_context->submit(command_buffer);
+    return _last_transfer;
+}
+
+void vulkan_image::write_region(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t mip_level,
+                                uint32_t layer, const void* data, uint64_t row_pitch) {
+    if (immutable()) throw std::runtime_error("Cannot write to an immutable image");
+    if (generates_mipmaps()) throw std::runtime_error("Cannot write regions of an image with generated mipmaps");
+    check_region(x, y, width, height, mip_level, layer);
+
+    // Rows are packed as they are recorded, so that the copy can assume tightly packed data
+    uint64_t packed_row_pitch = region_row_pitch(width);
+    uint32_t rows = region_rows(height);
+    if (row_pitch == 0) row_pitch = packed_row_pitch;
+    if (row_pitch < packed_row_pitch) throw std::runtime_error("Row pitch is smaller than a row of the region");
+
+    // Slices of 3D images are offsets into their only layer
+    bool slice = type() == graphics_image_type::image_3d;
+    vulkan_image_region region = {
+        .copy =
+            {
+                .bufferOffset = 0,
+                .bufferRowLength = 0,
+                .bufferImageHeight = 0,
+                .imageSubresource =
+                    {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .mipLevel = mip_level,
+                        .baseArrayLayer = slice ? 0 : layer,
+                        .layerCount = 1,
+                    },
+                .imageOffset = {.x = (int32_t) x, .y = (int32_t) y, .z = slice ? (int32_t) layer : 0},
+                .imageExtent = {.width = width, .height = height, .depth = 1},
+            },
+        .data = std::vector<uint8_t>(packed_row_pitch * rows),
+    };
+
+    for (uint32_t row = 0; row < rows; row++)
+        memcpy(region.data.data() + row * packed_row_pitch, (const uint8_t*) data + row * row_pitch,
+               packed_row_pitch);
+
+    if (_pending_regions.empty()) _transfer_context->defer(this);
+    _pending_regions.push_back(std::move(region));
+}
+
+std::unique_ptr<graphics_readback> vulkan_image::read_async(uint32_t mip_level, uint32_t layer) {
+    if (mip_level >= mip_levels()) throw std::runtime_error("Image mip level is out of range");
+    if (layer >= layers()) throw std::runtime_error("Image layer is out of range");
+
+    // Pending regions must reach the image before it is copied
+    if (!_pending_regions.empty()) _transfer_context->flush_deferred();
+
+    VkImageLayout layout = _layouts[mip_level * layers() + layer];
+    if (layout == VK_IMAGE_LAYOUT_UNDEFINED) throw std::runtime_error("Cannot read an image level before writing it");
+
+    // Copied on the graphics queue that reads the image, which orders the copy after earlier rendering without a queue
+    // family ownership transfer. Writes submitted to the transfer queue are waited on first.
+    _transfer_context->wait(_last_transfer);
+    uint64_t size = level_size(mip_level);
+    auto readback = _transfer_context->readback_pool().acquire(size);
+    if (!readback.is_ok()) throw std::runtime_error("Failed to allocate readback memory: " + readback.error());
+    VkCommandBuffer command_buffer = _transfer_context->begin_graphics();
+
     VkImageMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+        .oldLayout = layout,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = _image.image,
+        .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, mip_level, 1, layer, 1},
+    };
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    VkBufferImageCopy region = copy_region(0, mip_level, layer);
+    vkCmdCopyImageToBuffer(command_buffer, _image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.get().buffer, 1,
+                           &region);
+
+    // Return the level to the layout it was in
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.newLayout = layout;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0,
+                         nullptr, 0, nullptr, 1, &barrier);
+    vulkan_readback_pool::record_host_read_barrier(command_buffer);
+
+    _last_transfer = _transfer_context->submit_graphics(command_buffer);
+    return std::make_unique<vulkan_readback>(*_transfer_context, readback.get(), size, _last_transfer);
+}
+
+void vulkan_image::track_transfer(graphics_transfer_token token) {
+    _last_transfer = token;
+}
+
+void vulkan_image::track_write(uint32_t mip_level, uint32_t layer) {
+    auto range = subresource_range(mip_level, layer);
+    auto written = [&](uint32_t level, uint32_t array_layer) {
+        return level >= range.baseMipLevel && level < range.baseMipLevel + range.levelCount &&
+               array_layer >= range.baseArrayLayer && array_layer < range.baseArrayLayer + range.layerCount;
+    };
+
+    for (uint32_t level = range.baseMipLevel; level < range.baseMipLevel + range.levelCount; level++)
+        for (uint32_t array_layer = range.baseArrayLayer; array_layer < range.baseArrayLayer + range.layerCount;
+             array_layer++)
+            _layouts[level * layers() + array_layer] = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    if (_pending_regions.empty()) return;
+    std::erase_if(_pending_regions, [&](const vulkan_image_region& region) {
+        return written(region.copy.imageSubresource.mipLevel, region.copy.imageSubresource.baseArrayLayer);
+    });
+    if (_pending_regions.empty()) _transfer_context->cancel_deferred(this);
+}
+
+void vulkan_image::record_deferred_writes(VkCommandBuffer command_buffer) {
+    // Writes submitted to the transfer queue are not ordered with the graphics queue that records the regions
+    _transfer_context->wait(_last_transfer);
+
+    VkDeviceSize total_size = 0;
+    for (const auto& region : _pending_regions)
+        total_size += region.data.size();
+
+    // Pack every region into one staging allocation
+    auto staging = _transfer_context->allocate_staging(total_size);
+    std::vector<VkBufferImageCopy> copies;
+    std::set<std::pair<uint32_t, uint32_t>> subresources;
+    VkDeviceSize staging_offset = 0;
+    for (const auto& region : _pending_regions) {
+        memcpy((uint8_t*) staging.data + staging_offset, region.data.data(), region.data.size());
+        VkBufferImageCopy copy = region.copy;
+        copy.bufferOffset = staging.offset + staging_offset;
+        copies.push_back(copy);
+        subresources.insert({copy.imageSubresource.mipLevel, copy.imageSubresource.baseArrayLayer});
+        staging_offset += region.data.size();
+    }
+    _transfer_context->flush_staging(staging, total_size);
+
+    // Subresources are transitioned from the layout the last write left them in, which keeps their contents. The
+    // transition waits for earlier shader reads of the image.
+    std::vector<VkImageMemoryBarrier> barriers;
+    for (auto [level, layer] : subresources)
+        barriers.push_back(transfer_dst_barrier(level, _layouts[level * layers() + layer], layer));
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0,
+                         nullptr, 0, nullptr, (uint32_t) barriers.size(), barriers.data());
+
+    vkCmdCopyBufferToImage(command_buffer, staging.buffer, _image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           (uint32_t) copies.size(), copies.data());
+
+    barriers.clear();
+    for (auto [level, layer] : subresources) {
+        barriers.push_back(shader_read_barrier(level, layer));
+        _layouts[level * layers() + layer] = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0,
+                         nullptr, 0, nullptr, (uint32_t) barriers.size(), barriers.data());
+
+    _pending_regions.clear();
+}
+
+VkImageSubresourceRange vulkan_image::subresource_range(uint32_t mip_level, uint32_t layer) const {
+    // Generated levels are all rewritten together, otherwise only the level being written is transitioned
+    return {
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel = generates_mipmaps() ? 0 : mip_level,
+        .levelCount = generates_mipmaps() ? mip_levels() : 1,
+        .baseArrayLayer = layer == ALL_LAYERS ? 0 : layer,
+        .layerCount = layer == ALL_LAYERS ? layers() : 1,
+    };
+}
+
+VkImageMemoryBarrier vulkan_image::transfer_dst_barrier(uint32_t mip_level, VkImageLayout old_layout,
+                                                        uint32_t layer) const {
+    return {
         .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
         .srcAccessMask = 0,
         .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .oldLayout = old_layout,
         .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
         .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
         .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .image = _image,
-        .subresourceRange =
-            {
-                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                .baseMipLevel = 0,
-                .levelCount = 1,
-                .baseArrayLayer = 0,
-                .layerCount = 1,
-            },
+        .image = _image.image,
+        .subresourceRange = subresource_range(mip_level, layer),
     };
-    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0,
-                         nullptr, 0, nullptr, 1, &barrier);
+}
 
-    // Copy buffer to image
-    VkBufferImageCopy region = {
-        .bufferOffset = 0,
+VkImageMemoryBarrier vulkan_image::shader_read_barrier(uint32_t mip_level, uint32_t layer) const {
+    VkImageMemoryBarrier barrier = transfer_dst_barrier(mip_level, VK_IMAGE_LAYOUT_UNDEFINED, layer);
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    return barrier;
+}
+
+VkBufferImageCopy vulkan_image::copy_region(VkDeviceSize buffer_offset, uint32_t mip_level, uint32_t layer) const {
+    return {
+        .bufferOffset = buffer_offset,
         .bufferRowLength = 0,
         .bufferImageHeight = 0,
         .imageSubresource =
             {
                 .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                .mipLevel = 0,
-                .baseArrayLayer = 0,
-                .layerCount = 1,
+                .mipLevel = mip_level,
+                .baseArrayLayer = layer == ALL_LAYERS ? 0 : layer,
+                .layerCount = layer == ALL_LAYERS ? layers() : 1,
             },
         .imageOffset = {.x = 0, .y = 0, .z = 0},
-        .imageExtent = {.width = width(), .height = height(), .depth = 1},
+        .imageExtent =
+            {
+                .width = level_width(mip_level),
+                .height = level_height(mip_level),
+                .depth = level_depth(mip_level),
+            },
     };
-    vkCmdCopyBufferToImage(command_buffer, _staging_buffer, _image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+}
 
-    // Transition image to shader read
+void vulkan_image::record_mipmaps(VkCommandBuffer command_buffer, uint32_t layer) const {
+    VkImageMemoryBarrier barrier = transfer_dst_barrier(0, VK_IMAGE_LAYOUT_UNDEFINED, layer);
+    barrier.subresourceRange.levelCount = 1;
+    uint32_t base_layer = barrier.subresourceRange.baseArrayLayer;
+    uint32_t layer_count = barrier.subresourceRange.layerCount;
+
+    int32_t level_width = (int32_t) width();
+    int32_t level_height = (int32_t) height();
+    int32_t level_depth = (int32_t) depth();
+    for (uint32_t level = 1; level < mip_levels(); level++) {
+        // The level above becomes the blit source
+        barrier.subresourceRange.baseMipLevel = level - 1;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0,
+                             nullptr, 0, nullptr, 1, &barrier);
+
+        int32_t next_width = std::max(level_width / 2, 1);
+        int32_t next_height = std::max(level_height / 2, 1);
+        int32_t next_depth = std::max(level_depth / 2, 1);
+        VkImageBlit blit = {
+            .srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, base_layer, layer_count},
+            .srcOffsets = {{0, 0, 0}, {level_width, level_height, level_depth}},
+            .dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, base_layer, layer_count},
+            .dstOffsets = {{0, 0, 0}, {next_width, next_height, next_depth}},
+        };
+        vkCmdBlitImage(command_buffer, _image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, _image.image,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+        // The level above is done
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                             0, nullptr, 0, nullptr, 1, &barrier);
+
+        level_width = next_width;
+        level_height = next_height;
+        level_depth = next_depth;
+    }
+
+    // The last level was only ever written
+    barrier.subresourceRange.baseMipLevel = mip_levels() - 1;
     barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
     barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
     barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
     barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
     vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0,
                          nullptr, 0, nullptr, 1, &barrier);
-
-    // Submit transfer command buffer
-    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) throw std::runtime_error("Failed to end command buffer");
-
-    VkSubmitInfo submit_info = {
-        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .commandBufferCount = 1,
-        .pCommandBuffers = &command_buffer,
-    };
-
-    if (vkQueueSubmit(_transfer_queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS)
-        throw std::runtime_error("Failed to submit command buffer");
-
-    vkQueueWaitIdle(_transfer_queue);
-    vkFreeCommandBuffers(_device, _transfer_command_pool, 1, &command_buffer);
 }
 
 VkImage vulkan_image::image() const {
-    return _image;
+    return _image.image;
 }
 
 VkImageView vulkan_image::image_view() const {
     return _image_view;
 }
+
+VkFormat vulkan_image::vk_format(graphics_image_format format) {
+    switch (format) {
+        case graphics_image_format::rgba_8_srgb:
+            return VK_FORMAT_R8G8B8A8_SRGB;
+        case graphics_image_format::rgba_8_unorm:
+            return VK_FORMAT_R8G8B8A8_UNORM;
+        case graphics_image_format::bc1_srgb:
+            return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+        case graphics_image_format::bc1_unorm:
+            return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case graphics_image_format::bc3_srgb:
+            return VK_FORMAT_BC3_SRGB_BLOCK;
+        case graphics_image_format::bc3_unorm:
+            return VK_FORMAT_BC3_UNORM_BLOCK;
+        case graphics_image_format::bc4_unorm:
+            return VK_FORMAT_BC4_UNORM_BLOCK;
+        case graphics_image_format::bc5_unorm:
+            return VK_FORMAT_BC5_UNORM_BLOCK;
+        case graphics_image_format::bc7_srgb:
+            return VK_FORMAT_BC7_SRGB_BLOCK;
+        case graphics_image_format::bc7_unorm:
+            return VK_FORMAT_BC7_UNORM_BLOCK;
+        case graphics_image_format::etc2_rgba_8_srgb:
+            return VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK;
+        case graphics_image_format::etc2_rgba_8_unorm:
+            return VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK;
+        case graphics_image_format::astc_4x4_srgb:
+            return VK_FORMAT_ASTC_4x4_SRGB_BLOCK;
+        case graphics_image_format::astc_4x4_unorm:
+            return VK_FORMAT_ASTC_4x4_UNORM_BLOCK;
+    }
+    return VK_FORMAT_UNDEFINED;
+}
+
+bool vulkan_image::format_supported(VkPhysicalDevice physical_device, graphics_image_format format) {
+    VkFormatProperties format_properties;
+    vkGetPhysicalDeviceFormatProperties(physical_device, vk_format(format), &format_properties);
+
+    // Every image is created as a transfer source too, so that it can be read back
+    VkFormatFeatureFlags required =
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_SRC_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+    return (format_properties.optimalTilingFeatures & required) == required;
+}
@@ -2,43 +2,97 @@
 #define XGRAPHICS_VULKAN_IMAGE_H
 
 #include "vulkan_device_def.h"
+#include "vulkan_deletion_queue.h"
 #include "vulkan_memory_context.h"
+#include "vulkan_transfer_context.h"
 #include <result/result.h>
+#include <vector>
 #include <vulkan/vulkan.h>
 #include <xgraphics/interfaces/graphics_image.h>
 
 struct vulkan_image_init {
-    uint32_t width;
-    uint32_t height;
-    graphics_image_format format;
+    graphics_image_init image;
     VkDevice device;
     const vulkan_device_def* def;
     vulkan_memory_context* memory_context;
-    VkCommandPool transfer_command_pool;
-    VkQueue transfer_queue;
+    vulkan_transfer_context* transfer_context;
+    vulkan_deletion_queue* deletion_queue;
+};
+
+// A region waiting for the next deferred flush, whose copy offset is relative to its data
+struct vulkan_image_region {
+    VkBufferImageCopy copy;
+    std::vector<uint8_t> data;
 };
 
 class vulkan_image : public graphics_image {
     VkDevice _device;
     vulkan_memory_context* _memory_context;
-    VkCommandPool _transfer_command_pool;
-    VkQueue _transfer_queue;
+    vulkan_deletion_queue* _deletion_queue;
+    vulkan_transfer_context* _transfer_context;
+    graphics_transfer_token _last_transfer;
 
-    VkBuffer _staging_buffer;
-    VkImage _image;
+    vulkan_image_allocation _image;
     VkImageView _image_view;
 
-    vulkan_image(const vulkan_image_init& init, VkBuffer staging_buffer, VkImage image, VkImageView image_view);
+    // The layout each subresource is left in by the commands recorded so far, indexed by level and then layer
+    std::vector<VkImageLayout> _layouts;
+    std::vector<vulkan_image_region> _pending_regions;
+
+    vulkan_image(const vulkan_image_init& init, const vulkan_image_allocation& image, VkImageView image_view);
+
+    graphics_transfer_token write_subresource_async(uint32_t mip_level, uint32_t layer, const void* data,
+                                                    uint64_t size);
+    [[nodiscard]] VkImageSubresourceRange subresource_range(uint32_t mip_level, uint32_t layer) const;
 
   public:
+    static constexpr uint32_t ALL_LAYERS = UINT32_MAX;
+
     ~vulkan_image() override;
 
     static result::ptr<graphics_image> create(const vulkan_image_init& init);
 
-    void write(const void* data, uint32_t size) override;
+    void write(const void* data, uint64_t size) override;
+    graphics_transfer_token write_async(const void* data, uint64_t size) override;
+    void write_level(uint32_t mip_level, const void* data, uint64_t size) override;
+    graphics_transfer_token write_level_async(uint32_t mip_level, const void* data, uint64_t size) override;
+    void write_layer(uint32_t layer, uint32_t mip_level, const void* data, uint64_t size) override;
+    graphics_transfer_token write_layer_async(uint32_t layer, uint32_t mip_level, const void* data,
+                                              uint64_t size) override;
+    void write_region(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t mip_level, uint32_t layer,
+                      const void* data, uint64_t row_pitch) override;
+    std::unique_ptr<graphics_readback> read_async(uint32_t mip_level, uint32_t layer) override;
+
+    // Used when the image is written as part of a batch
+    void track_transfer(graphics_transfer_token token);
+
+    // Called once a write of the whole level has been recorded, which leaves it ready for shader reads and
+    // supersedes any pending regions of it
+    void track_write(uint32_t mip_level, uint32_t layer = ALL_LAYERS);
+
+    // Transitioning from the undefined layout discards the existing contents, which is only valid for whole levels
+    [[nodiscard]] VkImageMemoryBarrier transfer_dst_barrier(uint32_t mip_level = 0,
+                                                            VkImageLayout old_layout = VK_IMAGE_LAYOUT_UNDEFINED,
+                                                            uint32_t layer = ALL_LAYERS) const;
+    [[nodiscard]] VkImageMemoryBarrier shader_read_barrier(uint32_t mip_level = 0, uint32_t layer = ALL_LAYERS) const;
+    [[nodiscard]] VkBufferImageCopy copy_region(VkDeviceSize buffer_offset, uint32_t mip_level = 0,
+                                                uint32_t layer = ALL_LAYERS) const;
+
+    // Blits every level from the one above it, starting from the top level in the transfer destination layout, and
+    // leaves them all ready for shader reads. Must be recorded on a graphics capable queue.
+    void record_mipmaps(VkCommandBuffer command_buffer, uint32_t layer = ALL_LAYERS) const;
+
+    // Copies every pending region with one command, keeping the rest of the contents of their levels. Must be recorded
+    // on the graphics queue.
+    void record_deferred_writes(VkCommandBuffer command_buffer);
 
     [[nodiscard]] VkImage image() const;
     [[nodiscard]] VkImageView image_view() const;
+
+    static VkFormat vk_format(graphics_image_format format);
+
+    // Whether images of the format can be created, written and sampled
+    static bool format_supported(VkPhysicalDevice physical_device, graphics_image_format format);
 };
 
 #endif
@@ -2,6 +2,7 @@
 
 #include "../common/macos/macos_graphics_helpers.h"
 #include "vulkan_device.h"
+#include "vulkan_utils.h"
 
 vulkan_instance::vulkan_instance(const graphics_config& config, VkInstance instance, VkSurfaceKHR surface)
     : graphics_instance(config), _instance(instance), _surface(surface) { }
@@ -31,6 +32,12 @@ result::ptr<graphics_instance> vulkan_instance::create(const graphics_config& co
         // TODO: Add other platforms
     };
 
+#ifndef __APPLE__
+    // Needed for device extensions such as VK_EXT_memory_budget
+    if (vulkan_utils::instance_extension_supported(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+        extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+#endif
+
     const std::vector<const char*> enabled_layers = {"VK_LAYER_KHRONOS_validation"};
 
     VkInstanceCreateInfo create_info = {
@@ -1,14 +1,17 @@
 #include "vulkan_memory_context.h"
+#include <algorithm>
 
-vulkan_memory_context::vulkan_memory_context(VmaAllocator allocator) : _allocator(allocator) { }
+vulkan_memory_context::vulkan_memory_context(VmaAllocator allocator, bool host_visible_device_memory)
+    : _allocator(allocator), _host_visible_device_memory(host_visible_device_memory) { }
 
 vulkan_memory_context::~vulkan_memory_context() {
     vmaDestroyAllocator(_allocator);
 }
 
 result::ptr<vulkan_memory_context> vulkan_memory_context::create(VkInstance instance, VkDevice device,
-                                                                 VkPhysicalDevice physical_device) {
+                                                                 VkPhysicalDevice physical_device, bool memory_budget) {
     VmaAllocatorCreateInfo allocator_info = {
+        .flags = memory_budget ? (VmaAllocatorCreateFlags) VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT : 0,
         .physicalDevice = physical_device,
         .device = device,
         .instance = instance,
@@ -18,86 +21,179 @@ result::ptr<vulkan_memory_context> vulkan_memory_context::create(VkInstance inst
     if (vmaCreateAllocator(&allocator_info, &allocator) != VK_SUCCESS)
         return result::err("Failed to create VMA allocator");
 
-    return result::ok(new vulkan_memory_context(allocator));
+    const VkPhysicalDeviceMemoryProperties* memory_properties;
+    vmaGetMemoryProperties(allocator, &memory_properties);
+
+    // Discrete GPUs often expose only a small host visible window into device memory, which is not worth filling
+    // with buffers. It is used when the device is integrated, or when the window is as large as device memory.
+    VkDeviceSize device_heap_size = 0;
+    VkDeviceSize host_visible_device_heap_size = 0;
+    VkMemoryPropertyFlags host_visible_device_flags =
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    for (uint32_t i = 0; i < memory_properties->memoryTypeCount; i++) {
+        auto flags = memory_properties->memoryTypes[i].propertyFlags;
+        auto heap_size = memory_properties->memoryHeaps[memory_properties->memoryTypes[i].heapIndex].size;
+        if (flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) device_heap_size = std::max(device_heap_size, heap_size);
+        if ((flags & host_visible_device_flags) == host_visible_device_flags)
+            host_visible_device_heap_size = std::max(host_visible_device_heap_size, heap_size);
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    bool integrated = properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU;
+    bool host_visible_device_memory =
+        host_visible_device_heap_size > 0 && (integrated || host_visible_device_heap_size >= device_heap_size);
+
+    return result::ok(new vulkan_memory_context(allocator, host_visible_device_memory));
 }
 
-result::val<VkBuffer> vulkan_memory_context::create_staging_buffer(VkBufferCreateInfo buffer_info) {
+result::val<vulkan_buffer_allocation> vulkan_memory_context::create_staging_buffer(VkBufferCreateInfo buffer_info) {
     VmaAllocationCreateInfo allocation_info = {
         .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
         .usage = VMA_MEMORY_USAGE_AUTO,
     };
 
-    return create_buffer(buffer_info, allocation_info);
+    return create_buffer(buffer_info, allocation_info, vulkan_memory_kind::staging);
 }
 
-result::val<VkBuffer> vulkan_memory_context::create_gpu_buffer(VkBufferCreateInfo buffer_info) {
-    // TODO: Make sure this gets created locally
+result::val<vulkan_buffer_allocation> vulkan_memory_context::create_readback_buffer(VkBufferCreateInfo buffer_info) {
     VmaAllocationCreateInfo allocation_info = {
-        .usage = VMA_MEMORY_USAGE_AUTO,
+        .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+        .usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+    };
+
+    return create_buffer(buffer_info, allocation_info, vulkan_memory_kind::readback);
+}
+
+result::val<vulkan_buffer_allocation> vulkan_memory_context::create_gpu_buffer(VkBufferCreateInfo buffer_info,
+                                                                               vulkan_memory_kind kind) {
+    VmaAllocationCreateInfo allocation_info = {
+        .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
     };
 
-    return create_buffer(buffer_info, allocation_info);
+    return create_buffer(buffer_info, allocation_info, kind);
 }
 
-result::val<VkBuffer> vulkan_memory_context::create_mapped_buffer(VkBufferCreateInfo buffer_info) {
+result::val<vulkan_buffer_allocation>
+vulkan_memory_context::create_host_visible_gpu_buffer(VkBufferCreateInfo buffer_info, vulkan_memory_kind kind) {
+    // VMA falls back to memory that is not host visible if the host visible device heap is full
+    VmaAllocationCreateInfo allocation_info = {
+        .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+                 VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+        .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+    };
+
+    return create_buffer(buffer_info, allocation_info, kind);
+}
+
+result::val<vulkan_buffer_allocation> vulkan_memory_context::create_mapped_buffer(VkBufferCreateInfo buffer_info,
+                                                                                  vulkan_memory_kind kind) {
     VmaAllocationCreateInfo allocation_info = {
         .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
         .usage = VMA_MEMORY_USAGE_AUTO,
     };
 
-    return create_buffer(buffer_info, allocation_info);
+    return create_buffer(buffer_info, allocation_info, kind);
 }
 
-result::val<VkImage> vulkan_memory_context::create_gpu_image(VkImageCreateInfo image_info) {
+result::val<vulkan_image_allocation> vulkan_memory_context::create_gpu_image(VkImageCreateInfo image_info,
+                                                                             vulkan_memory_kind kind) {
     VmaAllocationCreateInfo allocation_info = {
         .usage = VMA_MEMORY_USAGE_AUTO,
     };
 
-    return create_image(image_info, allocation_info);
+    return create_image(image_info, allocation_info, kind);
+}
+
+void vulkan_memory_context::destroy_buffer(const vulkan_buffer_allocation& buffer) {
+    vmaDestroyBuffer(_allocator, buffer.buffer, buffer.allocation);
+    _kind_bytes[(size_t) buffer.kind] -= buffer.size;
+}
+
+void vulkan_memory_context::destroy_image(const vulkan_image_allocation& image) {
+    vmaDestroyImage(_allocator, image.image, image.allocation);
+    _kind_bytes[(size_t) image.kind] -= image.size;
 }
 
-void vulkan_memory_context::destroy_buffer(VkBuffer buffer) {
-    auto allocation = _buffer_allocations.at(buffer);
-    vmaDestroyBuffer(_allocator, buffer, allocation);
-    _buffer_allocations.erase(buffer);
+bool vulkan_memory_context::has_host_visible_device_memory() const {
+    return _host_visible_device_memory;
 }
 
-void vulkan_memory_context::destroy_image(VkImage image) {
-    auto allocation = _image_allocations.at(image);
-    vmaDestroyImage(_allocator, image, allocation);
-    _image_allocations.erase(image);
+void vulkan_memory_context::flush(VmaAllocation allocation, VkDeviceSize offset, VkDeviceSize size) {
+    vmaFlushAllocation(_allocator, allocation, offset, size);
 }
 
-void* vulkan_memory_context::map_buffer(VkBuffer buffer) {
-    auto allocation = _buffer_allocations.at(buffer);
-    void* data;
-    vmaMapMemory(_allocator, allocation, &data);
-    return data;
+void vulkan_memory_context::invalidate(VmaAllocation allocation, VkDeviceSize offset, VkDeviceSize size) {
+    vmaInvalidateAllocation(_allocator, allocation, offset, size);
 }
 
-void vulkan_memory_context::unmap_buffer(VkBuffer buffer) {
-    auto allocation = _buffer_allocations.at(buffer);
-    vmaUnmapMemory(_allocator, allocation);
+void vulkan_memory_context::advance_frame() {
+    // Lets VMA refresh its cached budget from the driver
+    vmaSetCurrentFrameIndex(_allocator, ++_frame_index);
 }
 
-result::val<VkBuffer> vulkan_memory_context::create_buffer(VkBufferCreateInfo buffer_info,
-                                                           VmaAllocationCreateInfo allocation_info) {
-    VkBuffer buffer;
-    VmaAllocation allocation;
-    if (vmaCreateBuffer(_allocator, &buffer_info, &allocation_info, &buffer, &allocation, nullptr) != VK_SUCCESS)
+graphics_memory_stats vulkan_memory_context::stats() {
+    const VkPhysicalDeviceMemoryProperties* memory_properties;
+    vmaGetMemoryProperties(_allocator, &memory_properties);
+
+    std::vector<VmaBudget> budgets(memory_properties->memoryHeapCount);
+    vmaGetHeapBudgets(_allocator, budgets.data());
+
+    graphics_memory_stats stats;
+    for (uint32_t i = 0; i < memory_properties->memoryHeapCount; i++) {
+        const auto& heap = memory_properties->memoryHeaps[i];
+        stats.heaps.push_back({
+            .size = heap.size,
+            .device_local = (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0,
+            .usage = budgets[i].usage,
+            .budget = budgets[i].budget,
+            .allocation_count = budgets[i].statistics.allocationCount,
+            .allocation_bytes = budgets[i].statistics.allocationBytes,
+        });
+        stats.allocation_count += budgets[i].statistics.allocationCount;
+    }
+
+    stats.vertex_buffer_bytes = _kind_bytes[(size_t) vulkan_memory_kind::vertex_buffer];
+    stats.index_buffer_bytes = _kind_bytes[(size_t) vulkan_memory_kind::index_buffer];
+    stats.uniform_buffer_bytes = _kind_bytes[(size_t) vulkan_memory_kind::uniform_buffer];
+    stats.indirect_buffer_bytes = _kind_bytes[(size_t) vulkan_memory_kind::indirect_buffer];
+    stats.other_buffer_bytes = _kind_bytes[(size_t) vulkan_memory_kind::other_buffer];
+    stats.image_bytes = _kind_bytes[(size_t) vulkan_memory_kind::image];
+    stats.staging_bytes = _kind_bytes[(size_t) vulkan_memory_kind::staging];
+    stats.readback_bytes = _kind_bytes[(size_t) vulkan_memory_kind::readback];
+    stats.depth_bytes = _kind_bytes[(size_t) vulkan_memory_kind::depth];
+    return stats;
+}
+
+result::val<vulkan_buffer_allocation> vulkan_memory_context::create_buffer(VkBufferCreateInfo buffer_info,
+                                                                           VmaAllocationCreateInfo allocation_info,
+                                                                           vulkan_memory_kind kind) {
+    vulkan_buffer_allocation buffer = {.kind = kind};
+    VmaAllocationInfo info;
+    if (vmaCreateBuffer(_allocator, &buffer_info, &allocation_info, &buffer.buffer, &buffer.allocation, &info) !=
+        VK_SUCCESS)
         return result::err("Failed to create buffer");
 
-    _buffer_allocations[buffer] = allocation;
+    // Mapped allocations may still end up in memory the host cannot see if VMA was allowed to fall back
+    VkMemoryPropertyFlags memory_flags;
+    vmaGetAllocationMemoryProperties(_allocator, buffer.allocation, &memory_flags);
+    if (memory_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) buffer.mapped_data = info.pMappedData;
+
+    buffer.size = info.size;
+    _kind_bytes[(size_t) kind] += info.size;
     return result::ok(buffer);
 }
 
-result::val<VkImage> vulkan_memory_context::create_image(VkImageCreateInfo image_info,
-                                                         VmaAllocationCreateInfo allocation_info) {
-    VkImage image;
-    VmaAllocation allocation;
-    if (vmaCreateImage(_allocator, &image_info, &allocation_info, &image, &allocation, nullptr) != VK_SUCCESS)
+result::val<vulkan_image_allocation> vulkan_memory_context::create_image(VkImageCreateInfo image_info,
+                                                                         VmaAllocationCreateInfo allocation_info,
+                                                                         vulkan_memory_kind kind) {
+    vulkan_image_allocation image = {.kind = kind};
+    VmaAllocationInfo info;
+    if (vmaCreateImage(_allocator, &image_info, &allocation_info, &image.image, &image.allocation, &info) !=
+        VK_SUCCESS)
         return result::err("Failed to create image");
 
-    _image_allocations[image] = allocation;
+    image.size = info.size;
+    _kind_bytes[(size_t) kind] += info.size;
     return result::ok(image);
-}
\ No newline at end of file
+}
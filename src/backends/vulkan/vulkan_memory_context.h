@@ -1,38 +1,89 @@
 #ifndef XGRAPHICS_VULKAN_MEMORY_CONTEXT_H
 #define XGRAPHICS_VULKAN_MEMORY_CONTEXT_H
 
+#include <array>
+#include <atomic>
 #include <result/result.h>
-#include <unordered_map>
 #include <vk_mem_alloc.h>
+#include <xgraphics/interfaces/graphics_memory.h>
 
+enum class vulkan_memory_kind {
+    vertex_buffer,
+    index_buffer,
+    uniform_buffer,
+    indirect_buffer,
+    other_buffer,
+    image,
+    staging,
+    readback,
+    depth,
+    count,
+};
+
+struct vulkan_buffer_allocation {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VmaAllocation allocation = VK_NULL_HANDLE;
+    vulkan_memory_kind kind = vulkan_memory_kind::staging;
+    VkDeviceSize size = 0;
+
+    // Set when the buffer is persistently mapped, and the host can write to it directly
+    void* mapped_data = nullptr;
+};
+
+struct vulkan_image_allocation {
+    VkImage image = VK_NULL_HANDLE;
+    VmaAllocation allocation = VK_NULL_HANDLE;
+    vulkan_memory_kind kind = vulkan_memory_kind::image;
+    VkDeviceSize size = 0;
+};
+
+// Resources are created together with their allocation record, so no lookups are needed to map or destroy them.
+// VMA synchronizes internally, which makes every method safe to call from multiple threads.
 class vulkan_memory_context {
     VmaAllocator _allocator;
-    std::unordered_map<VkBuffer, VmaAllocation> _buffer_allocations;
-    std::unordered_map<VkImage, VmaAllocation> _image_allocations;
+    bool _host_visible_device_memory;
+    std::array<std::atomic<uint64_t>, (size_t) vulkan_memory_kind::count> _kind_bytes = {};
+    uint32_t _frame_index = 0;
 
-    explicit vulkan_memory_context(VmaAllocator allocator);
+    explicit vulkan_memory_context(VmaAllocator allocator, bool host_visible_device_memory);
 
   public:
     vulkan_memory_context(const vulkan_memory_context&) = delete;
     ~vulkan_memory_context();
 
+    // The memory budget extension must be enabled on the device for the budgets to come from the driver
     static result::ptr<vulkan_memory_context> create(VkInstance instance, VkDevice device,
-                                                     VkPhysicalDevice physical_device);
+                                                     VkPhysicalDevice physical_device, bool memory_budget);
+
+    result::val<vulkan_buffer_allocation> create_staging_buffer(VkBufferCreateInfo buffer_info);
+
+    // Mapped, and preferably cached, so that the host can read it back quickly
+    result::val<vulkan_buffer_allocation> create_readback_buffer(VkBufferCreateInfo buffer_info);
+    result::val<vulkan_buffer_allocation> create_gpu_buffer(VkBufferCreateInfo buffer_info, vulkan_memory_kind kind);
+    result::val<vulkan_buffer_allocation> create_host_visible_gpu_buffer(VkBufferCreateInfo buffer_info,
+                                                                         vulkan_memory_kind kind);
+    result::val<vulkan_buffer_allocation> create_mapped_buffer(VkBufferCreateInfo buffer_info, vulkan_memory_kind kind);
+    result::val<vulkan_image_allocation> create_gpu_image(VkImageCreateInfo image_info, vulkan_memory_kind kind);
+
+    void destroy_buffer(const vulkan_buffer_allocation& buffer);
+    void destroy_image(const vulkan_image_allocation& image);
 
-    result::val<VkBuffer> create_staging_buffer(VkBufferCreateInfo buffer_info);
-    result::val<VkBuffer> create_gpu_buffer(VkBufferCreateInfo buffer_info);
-    result::val<VkBuffer> create_mapped_buffer(VkBufferCreateInfo buffer_info);
-    result::val<VkImage> create_gpu_image(VkImageCreateInfo image_info);
+    // True on UMA devices, and on discrete devices with resizable BAR
+    [[nodiscard]] bool has_host_visible_device_memory() const;
 
-    void destroy_buffer(VkBuffer buffer);
-    void destroy_image(VkImage image);
+    void flush(VmaAllocation allocation, VkDeviceSize offset, VkDeviceSize size);
+    void invalidate(VmaAllocation allocation, VkDeviceSize offset, VkDeviceSize size);
 
-    [[nodiscard]] void* map_buffer(VkBuffer buffer);
-    void unmap_buffer(VkBuffer buffer);
+    void advance_frame();
+    [[nodiscard]] graphics_memory_stats stats();
 
   private:
-    result::val<VkBuffer> create_buffer(VkBufferCreateInfo buffer_info, VmaAllocationCreateInfo allocation_info);
-    result::val<VkImage> create_image(VkImageCreateInfo image_info, VmaAllocationCreateInfo allocation_info);
+    result::val<vulkan_buffer_allocation> create_buffer(VkBufferCreateInfo buffer_info,
+                                                        VmaAllocationCreateInfo allocation_info,
+                                                        vulkan_memory_kind kind);
+    result::val<vulkan_image_allocation> create_image(VkImageCreateInfo image_info,
+                                                      VmaAllocationCreateInfo allocation_info,
+                                                      vulkan_memory_kind kind);
 };
 
 #endif
@@ -6,14 +6,16 @@
 #include "vulkan_shader.h"
 #include "vulkan_utils.h"
 
-vulkan_pipeline::vulkan_pipeline(const graphics_pipeline_init& init, VkDevice device, VkPipeline pipeline)
-    : graphics_pipeline(init), _device(device), _pipeline(pipeline) { }
+vulkan_pipeline::vulkan_pipeline(const graphics_pipeline_init& init, VkDevice device, VkPipeline pipeline,
+                                 vulkan_deletion_queue& deletion_queue)
+    : graphics_pipeline(init), _device(device), _pipeline(pipeline), _deletion_queue(deletion_queue) { }
 
 vulkan_pipeline::~vulkan_pipeline() {
-    vkDestroyPipeline(_device, _pipeline, nullptr);
+    _deletion_queue.release([device = _device, pipeline = _pipeline] { vkDestroyPipeline(device, pipeline, nullptr); });
 }
 
-result::ptr<graphics_pipeline> vulkan_pipeline::create(const graphics_pipeline_init& init, VkDevice device) {
+result::ptr<graphics_pipeline> vulkan_pipeline::create(const graphics_pipeline_init& init, VkDevice device,
+                                                       vulkan_deletion_queue& deletion_queue) {
     const auto& render_pass = (const vulkan_render_pass&) init.render_pass;
 
     // Create shader stage state
@@ -182,7 +184,7 @@ result::ptr<graphics_pipeline> vulkan_pipeline::create(const graphics_pipeline_i
     if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline) != VK_SUCCESS)
         return result::err("Failed to create graphics pipeline");
 
-    return result::ok(new vulkan_pipeline(init, device, pipeline));
+    return result::ok(new vulkan_pipeline(init, device, pipeline, deletion_queue));
 }
 
 VkPipeline vulkan_pipeline::pipeline() const {
@@ -1,6 +1,7 @@
 #ifndef XGRAPHICS_VULKAN_PIPELINE_H
 #define XGRAPHICS_VULKAN_PIPELINE_H
 
+#include "vulkan_deletion_queue.h"
 #include <result/result.h>
 #include <vulkan/vulkan.h>
 #include <xgraphics/interfaces/graphics_pipeline.h>
@@ -8,13 +9,16 @@
 class vulkan_pipeline : public graphics_pipeline {
     VkDevice _device;
     VkPipeline _pipeline;
+    vulkan_deletion_queue& _deletion_queue;
 
-    vulkan_pipeline(const graphics_pipeline_init& init, VkDevice device, VkPipeline pipeline);
+    vulkan_pipeline(const graphics_pipeline_init& init, VkDevice device, VkPipeline pipeline,
+                    vulkan_deletion_queue& deletion_queue);
 
   public:
     ~vulkan_pipeline() override;
 
-    static result::ptr<graphics_pipeline> create(const graphics_pipeline_init& init, VkDevice device);
+    static result::ptr<graphics_pipeline> create(const graphics_pipeline_init& init, VkDevice device,
+                                                 vulkan_deletion_queue& deletion_queue);
 
     [[nodiscard]] VkPipeline pipeline() const;
 };
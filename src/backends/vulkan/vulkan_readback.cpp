@@ -0,0 +1,28 @@
+#include "vulkan_readback.h"
+
+vulkan_readback::vulkan_readback(vulkan_transfer_context& transfer_context, const vulkan_buffer_allocation& buffer,
+                                 uint64_t size, graphics_transfer_token transfer)
+    : graphics_readback(size), _transfer_context(transfer_context), _buffer(buffer), _transfer(transfer) { }
+
+vulkan_readback::~vulkan_readback() {
+    _transfer_context.wait(_transfer);
+    _transfer_context.readback_pool().release(_buffer);
+}
+
+bool vulkan_readback::ready() {
+    return _transfer_context.complete(_transfer);
+}
+
+void vulkan_readback::wait() {
+    _transfer_context.wait(_transfer);
+}
+
+const void* vulkan_readback::data() {
+    wait();
+    if (!_invalidated) {
+        _transfer_context.readback_pool().invalidate(_buffer, size());
+        _invalidated = true;
+    }
+
+    return _buffer.mapped_data;
+}
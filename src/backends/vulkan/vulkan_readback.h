@@ -0,0 +1,25 @@
+#ifndef XGRAPHICS_VULKAN_READBACK_H
+#define XGRAPHICS_VULKAN_READBACK_H
+
+#include "vulkan_memory_context.h"
+#include "vulkan_transfer_context.h"
+#include <xgraphics/interfaces/graphics_readback.h>
+
+// Owns a pooled readback buffer until it is destroyed, which waits for the copy into it to complete
+class vulkan_readback : public graphics_readback {
+    vulkan_transfer_context& _transfer_context;
+    vulkan_buffer_allocation _buffer;
+    graphics_transfer_token _transfer;
+    bool _invalidated = false;
+
+  public:
+    vulkan_readback(vulkan_transfer_context& transfer_context, const vulkan_buffer_allocation& buffer,
+                    uint64_t size, graphics_transfer_token transfer);
+    ~vulkan_readback() override;
+
+    bool ready() override;
+    void wait() override;
+    const void* data() override;
+};
+
+#endif
@@ -0,0 +1,97 @@
+#include "vulkan_readback_pool.h"
+#include <bit>
+
+vulkan_readback_pool::vulkan_readback_pool(vulkan_memory_context& memory_context,
+                                           vulkan_deletion_queue& deletion_queue,
+                                           const std::vector<uint32_t>& queue_families)
+    : _memory_context(memory_context), _deletion_queue(deletion_queue), _queue_families(queue_families) { }
+
+vulkan_readback_pool::~vulkan_readback_pool() {
+    for (const auto& [size, buffers] : _free_buffers)
+        for (const auto& free_buffer : buffers)
+            destroy(free_buffer.buffer);
+}
+
+result::ptr<vulkan_readback_pool> vulkan_readback_pool::create(vulkan_memory_context& memory_context,
+                                                               vulkan_deletion_queue& deletion_queue,
+                                                               const vulkan_device_def& def) {
+    std::vector<uint32_t> queue_families;
+    if (def.transfer_family != def.graphics_family)
+        queue_families = {def.transfer_family.value(), def.graphics_family.value()};
+
+    return result::ok(new vulkan_readback_pool(memory_context, deletion_queue, queue_families));
+}
+
+result::val<vulkan_buffer_allocation> vulkan_readback_pool::acquire(VkDeviceSize size) {
+    VkDeviceSize size_class = this->size_class(size);
+    auto free_buffers = _free_buffers.find(size_class);
+    if (free_buffers != _free_buffers.end() && !free_buffers->second.empty()) {
+        auto buffer = free_buffers->second.back().buffer;
+        free_buffers->second.pop_back();
+        return result::ok(buffer);
+    }
+
+    VkBufferCreateInfo buffer_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = size_class,
+        .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0,
+        .pQueueFamilyIndices = nullptr,
+    };
+
+    if (!_queue_families.empty()) {
+        buffer_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        buffer_info.queueFamilyIndexCount = (uint32_t) _queue_families.size();
+        buffer_info.pQueueFamilyIndices = _queue_families.data();
+    }
+
+    return _memory_context.create_readback_buffer(buffer_info);
+}
+
+void vulkan_readback_pool::release(const vulkan_buffer_allocation& buffer) {
+    if (buffer.size > MAX_POOLED_SIZE) {
+        destroy(buffer);
+        return;
+    }
+
+    _free_buffers[size_class(buffer.size)].push_back({buffer, _frame});
+}
+
+void vulkan_readback_pool::trim(uint64_t frame) {
+    _frame = frame;
+    for (auto& [size, buffers] : _free_buffers) {
+        std::erase_if(buffers, [&](const vulkan_free_readback_buffer& free_buffer) {
+            if (frame - free_buffer.released_frame < IDLE_FRAMES) return false;
+            destroy(free_buffer.buffer);
+            return true;
+        });
+    }
+}
+
+void vulkan_readback_pool::invalidate(const vulkan_buffer_allocation& buffer, VkDeviceSize size) {
+    _memory_context.invalidate(buffer.allocation, 0, size);
+}
+
+void vulkan_readback_pool::record_host_read_barrier(VkCommandBuffer command_buffer) {
+    VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+    };
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0,
+                         nullptr, 0, nullptr);
+}
+
+VkDeviceSize vulkan_readback_pool::size_class(VkDeviceSize size) {
+    // Rounding to a quarter of the power of two below the size wastes less than a quarter of the buffer. Buffers that
+    // are too large to be pooled keep their exact size.
+    size = std::max(size, MIN_SIZE);
+    if (size > MAX_POOLED_SIZE) return size;
+    VkDeviceSize step = std::bit_floor(size - 1) / 4;
+    return (size + step - 1) / step * step;
+}
+
+void vulkan_readback_pool::destroy(const vulkan_buffer_allocation& buffer) {
+    _deletion_queue.release([&memory_context = _memory_context, buffer] { memory_context.destroy_buffer(buffer); });
+}
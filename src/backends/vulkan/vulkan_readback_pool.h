@@ -0,0 +1,59 @@
+#ifndef XGRAPHICS_VULKAN_READBACK_POOL_H
+#define XGRAPHICS_VULKAN_READBACK_POOL_H
+
+#include "vulkan_deletion_queue.h"
+#include "vulkan_device_def.h"
+#include "vulkan_memory_context.h"
+#include <map>
+#include <result/result.h>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+struct vulkan_free_readback_buffer {
+    vulkan_buffer_allocation buffer;
+    uint64_t released_frame;
+};
+
+// Host readable buffers that readbacks copy into. Sizes are rounded up to one of four classes between each power of
+// two, and released buffers are kept in a free list per class, so that repeated readbacks of similar sizes do not
+// allocate. Buffers above MAX_POOLED_SIZE are not kept, and free buffers that stay unused for IDLE_FRAMES are released.
+class vulkan_readback_pool {
+    vulkan_memory_context& _memory_context;
+    vulkan_deletion_queue& _deletion_queue;
+    std::vector<uint32_t> _queue_families;
+    std::map<VkDeviceSize, std::vector<vulkan_free_readback_buffer>> _free_buffers;
+    uint64_t _frame = 0;
+
+    explicit vulkan_readback_pool(vulkan_memory_context& memory_context, vulkan_deletion_queue& deletion_queue,
+                                  const std::vector<uint32_t>& queue_families);
+
+  public:
+    static constexpr VkDeviceSize MIN_SIZE = 64 * 1024;
+    static constexpr VkDeviceSize MAX_POOLED_SIZE = 64 * 1024 * 1024;
+    static constexpr uint64_t IDLE_FRAMES = 120;
+
+    vulkan_readback_pool(const vulkan_readback_pool&) = delete;
+    ~vulkan_readback_pool();
+
+    static result::ptr<vulkan_readback_pool> create(vulkan_memory_context& memory_context,
+                                                    vulkan_deletion_queue& deletion_queue,
+                                                    const vulkan_device_def& def);
+
+    [[nodiscard]] result::val<vulkan_buffer_allocation> acquire(VkDeviceSize size);
+    void release(const vulkan_buffer_allocation& buffer);
+
+    // Releases free buffers that have not been reused for IDLE_FRAMES frames
+    void trim(uint64_t frame);
+
+    // Makes the copied data visible to the host once the copy has completed
+    void invalidate(const vulkan_buffer_allocation& buffer, VkDeviceSize size);
+
+    // Makes transfer writes to readback buffers available to the host. Recorded after the copies.
+    static void record_host_read_barrier(VkCommandBuffer command_buffer);
+
+  private:
+    static VkDeviceSize size_class(VkDeviceSize size);
+    void destroy(const vulkan_buffer_allocation& buffer);
+};
+
+#endif
@@ -80,8 +80,8 @@ result::ptr<graphics_render_pass> vulkan_render_pass::create(vulkan_swapchain& s
     if (vkCreateRenderPass(device, &render_pass_info, nullptr, &render_pass) != VK_SUCCESS)
         return result::err("Failed to create render pass");
 
-    // Create framebuffers
-    swapchain.create_framebuffers(render_pass);
+    // Framebuffers are created when the render pass is first begun
+    swapchain.add_render_pass(render_pass);
 
     return result::ok(new vulkan_render_pass(swapchain, device, render_pass));
 }
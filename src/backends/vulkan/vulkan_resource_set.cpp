@@ -1,4 +1,5 @@
 #include "vulkan_resource_set.h"
+#include "vulkan_buffer.h"
 #include "vulkan_image.h"
 #include "vulkan_sampler.h"
 #include "vulkan_uniform_buffer.h"
@@ -11,10 +12,11 @@ vulkan_resource_set::vulkan_resource_set(const vulkan_resource_set_init& init, V
       _pool(pool),
       _pipeline_layout(((const vulkan_resource_layout&) init.layout).layout()),
       _descriptor_sets(descriptor_sets),
-      _sync_context(&init.sync_context) { }
+      _sync_context(&init.sync_context),
+      _deletion_queue(&init.deletion_queue) { }
 
 vulkan_resource_set::~vulkan_resource_set() {
-    vkDestroyDescriptorPool(_device, _pool, nullptr);
+    _deletion_queue->release([device = _device, pool = _pool] { vkDestroyDescriptorPool(device, pool, nullptr); });
 }
 
 result::ptr<graphics_resource_set> vulkan_resource_set::create(const vulkan_resource_set_init& init) {
@@ -84,6 +86,29 @@ void vulkan_resource_set::bind_uniform_buffer(resource_binding_ref binding, cons
     }
 }
 
+void vulkan_resource_set::bind_uniform_buffer(resource_binding_ref binding, const graphics_buffer& buffer,
+                                              uint64_t offset, uint64_t size) {
+    const auto& native_buffer = (const vulkan_buffer&) buffer;
+
+    VkDescriptorBufferInfo buffer_info = {
+        .buffer = native_buffer.buffer(),
+        .offset = offset,
+        .range = size,
+    };
+
+    VkWriteDescriptorSet descriptor_write = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = _descriptor_sets[_sync_context->current_frame()],
+        .dstBinding = binding->backend_binding,
+        .dstArrayElement = 0, // TODO: Arrays
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+        .pBufferInfo = &buffer_info,
+    };
+
+    vkUpdateDescriptorSets(_device, 1, &descriptor_write, 0, nullptr);
+}
+
 void vulkan_resource_set::bind_sampled_image(resource_binding_ref binding, const graphics_image& image,
                                              const graphics_sampler& sampler) {
     const auto& native_image = (const vulkan_image&) image;
@@ -1,6 +1,7 @@
 #ifndef XGRAPHICS_VULKAN_RESOURCE_SET_H
 #define XGRAPHICS_VULKAN_RESOURCE_SET_H
 
+#include "vulkan_deletion_queue.h"
 #include "vulkan_resource_layout.h"
 #include "vulkan_sync_context.h"
 #include <vulkan/vulkan.h>
@@ -11,6 +12,7 @@ struct vulkan_resource_set_init {
     const vulkan_resource_layout& layout;
     resource_set_ref ref;
     const vulkan_sync_context& sync_context;
+    vulkan_deletion_queue& deletion_queue;
 };
 
 class vulkan_resource_set : public graphics_resource_set {
@@ -19,6 +21,7 @@ class vulkan_resource_set : public graphics_resource_set {
     VkPipelineLayout _pipeline_layout;
     std::vector<VkDescriptorSet> _descriptor_sets;
     const vulkan_sync_context* _sync_context;
+    vulkan_deletion_queue* _deletion_queue;
 
     vulkan_resource_set(const vulkan_resource_set_init& init, VkDescriptorPool pool,
                         const std::vector<VkDescriptorSet>& descriptor_sets);
@@ -29,6 +32,8 @@ class vulkan_resource_set : public graphics_resource_set {
     static result::ptr<graphics_resource_set> create(const vulkan_resource_set_init& init);
 
     void bind_uniform_buffer(resource_binding_ref binding, const graphics_uniform_buffer& buffer) override;
+    void bind_uniform_buffer(resource_binding_ref binding, const graphics_buffer& buffer, uint64_t offset,
+                             uint64_t size) override;
     void bind_sampled_image(resource_binding_ref binding, const graphics_image& image,
                             const graphics_sampler& sampler) override;
 
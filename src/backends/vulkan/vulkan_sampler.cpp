@@ -1,13 +1,15 @@
 #include "vulkan_sampler.h"
 
-vulkan_sampler::vulkan_sampler(const graphics_sampler_init& init, VkDevice device, VkSampler sampler)
-    : graphics_sampler(init), _device(device), _sampler(sampler) { }
+vulkan_sampler::vulkan_sampler(const graphics_sampler_init& init, VkDevice device, VkSampler sampler,
+                               vulkan_deletion_queue& deletion_queue)
+    : graphics_sampler(init), _device(device), _sampler(sampler), _deletion_queue(deletion_queue) { }
 
 vulkan_sampler::~vulkan_sampler() {
-    vkDestroySampler(_device, _sampler, nullptr);
+    _deletion_queue.release([device = _device, sampler = _sampler] { vkDestroySampler(device, sampler, nullptr); });
 }
 
-result::ptr<graphics_sampler> vulkan_sampler::create(const graphics_sampler_init& init, VkDevice device) {
+result::ptr<graphics_sampler> vulkan_sampler::create(const graphics_sampler_init& init, VkDevice device,
+                                                     vulkan_deletion_queue& deletion_queue) {
     VkSamplerCreateInfo sampler_info = {
         .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
         .magFilter = vk_filter(init.mag_filter).get(),
@@ -16,13 +18,13 @@ result::ptr<graphics_sampler> vulkan_sampler::create(const graphics_sampler_init
         .addressModeU = vk_address_mode(init.address_mode.u).get(),
         .addressModeV = vk_address_mode(init.address_mode.v).get(),
         .addressModeW = vk_address_mode(init.address_mode.w).get(),
-        .mipLodBias = 0.0f,
+        .mipLodBias = init.lod_bias,
         .anisotropyEnable = VK_TRUE,
         .maxAnisotropy = init.max_anisotropy,
         .compareEnable = VK_FALSE,
         .compareOp = VK_COMPARE_OP_ALWAYS,
-        .minLod = 0.0f,
-        .maxLod = 0.0f,
+        .minLod = init.min_lod,
+        .maxLod = init.max_lod,
         .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
         .unnormalizedCoordinates = VK_FALSE,
     };
@@ -31,7 +33,7 @@ result::ptr<graphics_sampler> vulkan_sampler::create(const graphics_sampler_init
     if (vkCreateSampler(device, &sampler_info, nullptr, &sampler) != VK_SUCCESS)
         return result::err("failed to create texture sampler!");
 
-    return result::ok(new vulkan_sampler(init, device, sampler));
+    return result::ok(new vulkan_sampler(init, device, sampler, deletion_queue));
 }
 
 VkSampler vulkan_sampler::sampler() const {
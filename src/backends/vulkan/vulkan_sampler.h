@@ -1,6 +1,7 @@
 #ifndef XGRAPHICS_VULKAN_SAMPLER_H
 #define XGRAPHICS_VULKAN_SAMPLER_H
 
+#include "vulkan_deletion_queue.h"
 #include <result/result.h>
 #include <vulkan/vulkan.h>
 #include <xgraphics/interfaces/graphics_sampler.h>
@@ -8,13 +9,16 @@
 class vulkan_sampler : public graphics_sampler {
     VkDevice _device;
     VkSampler _sampler;
+    vulkan_deletion_queue& _deletion_queue;
 
-    vulkan_sampler(const graphics_sampler_init& init, VkDevice device, VkSampler sampler);
+    vulkan_sampler(const graphics_sampler_init& init, VkDevice device, VkSampler sampler,
+                   vulkan_deletion_queue& deletion_queue);
 
   public:
     ~vulkan_sampler() override;
 
-    static result::ptr<graphics_sampler> create(const graphics_sampler_init& init, VkDevice device);
+    static result::ptr<graphics_sampler> create(const graphics_sampler_init& init, VkDevice device,
+                                                vulkan_deletion_queue& deletion_queue);
 
     [[nodiscard]] VkSampler sampler() const;
 
@@ -0,0 +1,40 @@
+#include "vulkan_secondary_command_buffer.h"
+#include "vulkan_render_pass.h"
+
+vulkan_secondary_command_buffer::vulkan_secondary_command_buffer(std::unique_ptr<vulkan_command_pool> command_pool,
+                                                                 const vulkan_device_def& def,
+                                                                 const vulkan_device_functions& functions)
+    : vulkan_command_recorder(std::move(command_pool), def, functions) { }
+
+result::ptr<graphics_secondary_command_buffer>
+vulkan_secondary_command_buffer::create(VkDevice device, const vulkan_device_def& def,
+                                        const vulkan_device_functions& functions,
+                                        const vulkan_sync_context& sync_context,
+                                        vulkan_deletion_queue& deletion_queue) {
+    auto command_pool = GET_OR_FORWARD(vulkan_command_pool::create(device, def.graphics_family.value(),
+                                                                   VK_COMMAND_BUFFER_LEVEL_SECONDARY, sync_context,
+                                                                   deletion_queue));
+    return result::ok(new vulkan_secondary_command_buffer(std::move(command_pool), def, functions));
+}
+
+void vulkan_secondary_command_buffer::begin(const graphics_render_pass& render_pass) {
+    const auto& native_render_pass = (const vulkan_render_pass&) render_pass;
+    const auto& native_swapchain = (const vulkan_swapchain&) render_pass.swapchain();
+
+    // The framebuffer is left for the primary command buffer to provide, so recording doesn't depend on the
+    // acquired swapchain image
+    VkCommandBufferInheritanceInfo inheritance_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .renderPass = native_render_pass.render_pass(),
+        .subpass = 0,
+        .framebuffer = VK_NULL_HANDLE,
+    };
+
+    VkCommandBufferBeginInfo begin_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = &inheritance_info,
+    };
+    begin_recording(begin_info);
+    set_viewport(native_swapchain);
+}
@@ -0,0 +1,22 @@
+#ifndef XGRAPHICS_VULKAN_SECONDARY_COMMAND_BUFFER_H
+#define XGRAPHICS_VULKAN_SECONDARY_COMMAND_BUFFER_H
+
+#include "vulkan_command_recorder.h"
+#include <result/result.h>
+#include <vulkan/vulkan.h>
+#include <xgraphics/interfaces/graphics_secondary_command_buffer.h>
+
+class vulkan_secondary_command_buffer : public vulkan_command_recorder<graphics_secondary_command_buffer> {
+    explicit vulkan_secondary_command_buffer(std::unique_ptr<vulkan_command_pool> command_pool,
+                                             const vulkan_device_def& def, const vulkan_device_functions& functions);
+
+  public:
+    static result::ptr<graphics_secondary_command_buffer> create(VkDevice device, const vulkan_device_def& def,
+                                                                 const vulkan_device_functions& functions,
+                                                                 const vulkan_sync_context& sync_context,
+                                                                 vulkan_deletion_queue& deletion_queue);
+
+    void begin(const graphics_render_pass& render_pass) override;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#include "vulkan_semaphore.h"
+
+vulkan_semaphore::vulkan_semaphore(VkDevice device, VkSemaphore semaphore) : _device(device), _semaphore(semaphore) { }
+
+vulkan_semaphore::~vulkan_semaphore() {
+    vkDestroySemaphore(_device, _semaphore, nullptr);
+}
+
+result::ptr<graphics_semaphore> vulkan_semaphore::create(VkDevice device) {
+    VkSemaphoreCreateInfo semaphore_info = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+    };
+
+    VkSemaphore semaphore;
+    if (vkCreateSemaphore(device, &semaphore_info, nullptr, &semaphore) != VK_SUCCESS)
+        return result::err("Failed to create semaphore");
+
+    return result::ok(new vulkan_semaphore(device, semaphore));
+}
+
+VkSemaphore vulkan_semaphore::semaphore() const {
+    return _semaphore;
+}
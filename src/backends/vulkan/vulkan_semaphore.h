@@ -0,0 +1,22 @@
+#ifndef XGRAPHICS_VULKAN_SEMAPHORE_H
+#define XGRAPHICS_VULKAN_SEMAPHORE_H
+
+#include <result/result.h>
+#include <vulkan/vulkan.h>
+#include <xgraphics/interfaces/graphics_semaphore.h>
+
+class vulkan_semaphore : public graphics_semaphore {
+    VkDevice _device;
+    VkSemaphore _semaphore;
+
+    vulkan_semaphore(VkDevice device, VkSemaphore semaphore);
+
+  public:
+    ~vulkan_semaphore() override;
+
+    static result::ptr<graphics_semaphore> create(VkDevice device);
+
+    [[nodiscard]] VkSemaphore semaphore() const;
+};
+
+#endif
@@ -0,0 +1,145 @@
+#include "vulkan_staging_ring.h"
+
+vulkan_staging_ring::vulkan_staging_ring(vulkan_memory_context& memory_context,
+                                         const std::vector<uint32_t>& queue_families, uint32_t frames_in_flight)
+    : _memory_context(memory_context), _queue_families(queue_families), _regions(frames_in_flight) { }
+
+vulkan_staging_ring::~vulkan_staging_ring() {
+    for (const auto& region : _regions) {
+        for (const auto& chunk : region.chunks)
+            destroy_chunk(chunk);
+        for (const auto& chunk : region.dedicated_chunks)
+            destroy_chunk(chunk);
+    }
+    for (const auto& chunk : _stream_chunks)
+        destroy_chunk(chunk);
+}
+
+result::ptr<vulkan_staging_ring> vulkan_staging_ring::create(vulkan_memory_context& memory_context,
+                                                             const vulkan_device_def& def, uint32_t frames_in_flight) {
+    std::vector<uint32_t> queue_families;
+    if (def.transfer_family != def.graphics_family)
+        queue_families = {def.transfer_family.value(), def.graphics_family.value()};
+
+    auto ring = std::unique_ptr<vulkan_staging_ring>(
+        new vulkan_staging_ring(memory_context, queue_families, frames_in_flight));
+    for (auto& region : ring->_regions)
+        region.chunks.push_back(GET_OR_FORWARD(ring->create_chunk(CHUNK_SIZE)));
+
+    return result::ok(ring.release());
+}
+
+vulkan_staging_allocation vulkan_staging_ring::allocate(VkDeviceSize size) {
+    auto& region = _regions[_current_region];
+
+    if (size > CHUNK_SIZE) {
+        auto dedicated_chunk = create_chunk(size);
+        if (!dedicated_chunk.is_ok()) throw std::runtime_error("Failed to allocate staging memory");
+
+        region.dedicated_chunks.push_back(dedicated_chunk.get());
+        auto& chunk = region.dedicated_chunks.back();
+        chunk.offset = size;
+        return {chunk.buffer.buffer, chunk.buffer.allocation, 0, chunk.buffer.mapped_data};
+    }
+
+    auto& chunks = region.chunks;
+    auto* chunk = &chunks.back();
+    VkDeviceSize offset = (chunk->offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    if (offset + size > chunk->size) {
+        // Grow the region, it will be merged into a single chunk the next time it is reset
+        auto new_chunk = create_chunk(CHUNK_SIZE);
+        if (!new_chunk.is_ok()) throw std::runtime_error("Failed to grow staging ring");
+
+        chunks.push_back(new_chunk.get());
+        chunk = &chunks.back();
+        offset = 0;
+    }
+
+    chunk->offset = offset + size;
+    return {chunk->buffer.buffer, chunk->buffer.allocation, offset, (uint8_t*) chunk->buffer.mapped_data + offset};
+}
+
+void vulkan_staging_ring::flush(const vulkan_staging_allocation& allocation, VkDeviceSize size) {
+    _memory_context.flush(allocation.allocation, allocation.offset, size);
+}
+
+void vulkan_staging_ring::track(graphics_transfer_token token) {
+    _regions[_current_region].last_transfer = token;
+}
+
+graphics_transfer_token vulkan_staging_ring::last_transfer(uint32_t region) const {
+    return _regions[region].last_transfer;
+}
+
+void vulkan_staging_ring::reset(uint32_t region) {
+    _current_region = region;
+    auto& chunks = _regions[region].chunks;
+
+    for (const auto& chunk : _regions[region].dedicated_chunks)
+        destroy_chunk(chunk);
+    _regions[region].dedicated_chunks.clear();
+
+    VkDeviceSize total_size = 0;
+    VkDeviceSize used_size = 0;
+    for (const auto& chunk : chunks) {
+        total_size += chunk.size;
+        used_size += chunk.offset;
+    }
+
+    // Merge chunks added this frame, or give back memory a one-off burst of uploads left behind
+    VkDeviceSize new_size = total_size;
+    if (chunks.size() == 1 && total_size > CHUNK_SIZE && used_size < total_size / 4)
+        new_size = std::max(used_size * 2, CHUNK_SIZE);
+
+    if (chunks.size() > 1 || new_size != total_size) {
+        for (const auto& chunk : chunks)
+            destroy_chunk(chunk);
+        chunks.clear();
+
+        auto chunk = create_chunk(new_size);
+        if (!chunk.is_ok()) throw std::runtime_error("Failed to resize staging ring");
+        chunks.push_back(chunk.get());
+    }
+
+    chunks.back().offset = 0;
+    _regions[region].last_transfer = {};
+}
+
+vulkan_staging_allocation vulkan_staging_ring::stream_slot(uint32_t slot) {
+    while (_stream_chunks.size() <= slot) {
+        auto chunk = create_chunk(STREAM_CHUNK_SIZE);
+        if (!chunk.is_ok()) throw std::runtime_error("Failed to allocate stream staging memory");
+        _stream_chunks.push_back(chunk.get());
+    }
+
+    const auto& chunk = _stream_chunks[slot];
+    return {chunk.buffer.buffer, chunk.buffer.allocation, 0, chunk.buffer.mapped_data};
+}
+
+result::val<vulkan_staging_chunk> vulkan_staging_ring::create_chunk(VkDeviceSize size) {
+    VkBufferCreateInfo buffer_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = size,
+        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0,
+        .pQueueFamilyIndices = nullptr,
+    };
+
+    if (!_queue_families.empty()) {
+        buffer_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        buffer_info.queueFamilyIndexCount = (uint32_t) _queue_families.size();
+        buffer_info.pQueueFamilyIndices = _queue_families.data();
+    }
+
+    auto buffer = GET_OR_FORWARD(_memory_context.create_staging_buffer(buffer_info));
+    return result::ok(vulkan_staging_chunk {
+        .buffer = buffer,
+        .size = size,
+        .offset = 0,
+    });
+}
+
+void vulkan_staging_ring::destroy_chunk(const vulkan_staging_chunk& chunk) {
+    _memory_context.destroy_buffer(chunk.buffer);
+}
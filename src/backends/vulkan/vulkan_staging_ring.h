@@ -0,0 +1,72 @@
+#ifndef XGRAPHICS_VULKAN_STAGING_RING_H
+#define XGRAPHICS_VULKAN_STAGING_RING_H
+
+#include "vulkan_device_def.h"
+#include "vulkan_memory_context.h"
+#include <result/result.h>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <xgraphics/interfaces/graphics_transfer.h>
+
+struct vulkan_staging_allocation {
+    VkBuffer buffer;
+    VmaAllocation allocation;
+    VkDeviceSize offset;
+    void* data;
+};
+
+struct vulkan_staging_chunk {
+    vulkan_buffer_allocation buffer;
+    VkDeviceSize size;
+    VkDeviceSize offset;
+};
+
+struct vulkan_staging_region {
+    std::vector<vulkan_staging_chunk> chunks;
+    std::vector<vulkan_staging_chunk> dedicated_chunks;
+    graphics_transfer_token last_transfer;
+};
+
+// Persistently mapped staging memory shared by all uploads. There is one region per frame in flight; allocations
+// are bumped from the current region, which grows by adding chunks when it runs out of space. A region is reset
+// once the transfers that read from it have completed. Allocations larger than a chunk get memory of their own,
+// which is released on reset, and a region that is mostly unused shrinks back towards the chunk size. Writes too large
+// for that are instead streamed through a few fixed stream slots, which the caller reuses as their transfers complete.
+class vulkan_staging_ring {
+    vulkan_memory_context& _memory_context;
+    std::vector<uint32_t> _queue_families;
+    std::vector<vulkan_staging_region> _regions;
+    uint32_t _current_region = 0;
+    std::vector<vulkan_staging_chunk> _stream_chunks;
+
+    explicit vulkan_staging_ring(vulkan_memory_context& memory_context, const std::vector<uint32_t>& queue_families,
+                                 uint32_t frames_in_flight);
+
+  public:
+    static constexpr VkDeviceSize CHUNK_SIZE = 4 * 1024 * 1024;
+    static constexpr VkDeviceSize ALIGNMENT = 16;
+    static constexpr VkDeviceSize STREAM_CHUNK_SIZE = 16 * 1024 * 1024;
+    static constexpr uint32_t STREAM_SLOTS = 3;
+
+    vulkan_staging_ring(const vulkan_staging_ring&) = delete;
+    ~vulkan_staging_ring();
+
+    static result::ptr<vulkan_staging_ring> create(vulkan_memory_context& memory_context, const vulkan_device_def& def,
+                                                   uint32_t frames_in_flight);
+
+    [[nodiscard]] vulkan_staging_allocation allocate(VkDeviceSize size);
+    void flush(const vulkan_staging_allocation& allocation, VkDeviceSize size);
+    void track(graphics_transfer_token token);
+
+    [[nodiscard]] graphics_transfer_token last_transfer(uint32_t region) const;
+    void reset(uint32_t region);
+
+    // The whole slot, created on first use. The caller must wait for the last transfer that read from it.
+    [[nodiscard]] vulkan_staging_allocation stream_slot(uint32_t slot);
+
+  private:
+    result::val<vulkan_staging_chunk> create_chunk(VkDeviceSize size);
+    void destroy_chunk(const vulkan_staging_chunk& chunk);
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include "vulkan_swapchain.h"
 #include "vulkan_memory_context.h"
 
+#include <algorithm>
 #include <array>
 #include <vector>
 #include <vulkan/vulkan_core.h>
@@ -12,10 +13,12 @@ vulkan_swapchain::vulkan_swapchain(const vulkan_swapchain_init& init, const vulk
       _surface(init.surface),
       _sync_context(init.sync_context),
       _memory_context(init.memory_context),
+      _deletion_queue(init.deletion_queue),
+      _config(init.config),
       _state(state) { }
 
 vulkan_swapchain::~vulkan_swapchain() {
-    destroy();
+    release();
 }
 
 result::ptr<graphics_swapchain> vulkan_swapchain::create(const vulkan_swapchain_init& init) {
@@ -40,33 +43,15 @@ result::ptr<graphics_swapchain> vulkan_swapchain::create(const vulkan_swapchain_
     return result::ok(new vulkan_swapchain(init, state));
 }
 
-void vulkan_swapchain::create_framebuffers(VkRenderPass render_pass) {
-    auto& framebuffers = _framebuffers[render_pass];
-    framebuffers.clear();
-    for (const auto& view : image_views()) {
-        std::array<VkImageView, 2> attachments = {view, _state.depth_image_view};
-        VkFramebufferCreateInfo framebuffer_info = {
-            .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-            .renderPass = render_pass,
-            .attachmentCount = (uint32_t) attachments.size(),
-            .pAttachments = attachments.data(),
-            .width = _state.extent.width,
-            .height = _state.extent.height,
-            .layers = 1,
-        };
-
-        VkFramebuffer framebuffer;
-        if (vkCreateFramebuffer(_device, &framebuffer_info, nullptr, &framebuffer) != VK_SUCCESS)
-            throw std::runtime_error("Failed to create framebuffer");
-
-        framebuffers.push_back(framebuffer);
-    }
+void vulkan_swapchain::add_render_pass(VkRenderPass render_pass) {
+    _framebuffers[render_pass].assign(_state.images.size(), VK_NULL_HANDLE);
 }
 
 void vulkan_swapchain::destroy_framebuffers(VkRenderPass render_pass) {
-    auto& framebuffers = _framebuffers.at(render_pass);
-    for (const auto& framebuffer : framebuffers)
-        vkDestroyFramebuffer(_device, framebuffer, nullptr);
+    _deletion_queue.release([device = _device, framebuffers = _framebuffers.at(render_pass)] {
+        for (const auto& framebuffer : framebuffers)
+            if (framebuffer) vkDestroyFramebuffer(device, framebuffer, nullptr);
+    });
     _framebuffers.erase(render_pass);
 }
 
@@ -94,8 +79,18 @@ uint32_t vulkan_swapchain::current_index() const {
     return _current_index;
 }
 
-VkFramebuffer vulkan_swapchain::current_framebuffer(VkRenderPass render_pass) const {
-    return _framebuffers.at(render_pass)[_current_index];
+VkFramebuffer vulkan_swapchain::current_framebuffer(VkRenderPass render_pass) {
+    auto& framebuffer = _framebuffers.at(render_pass)[_current_index];
+    if (!framebuffer) framebuffer = create_framebuffer(render_pass, _current_index);
+    return framebuffer;
+}
+
+graphics_present_mode vulkan_swapchain::present_mode() const {
+    return _state.present_mode;
+}
+
+uint32_t vulkan_swapchain::image_count() const {
+    return (uint32_t) _state.images.size();
 }
 
 void vulkan_swapchain::swap() {
@@ -114,50 +109,71 @@ void vulkan_swapchain::resize(uint32_t width, uint32_t height) {
 
 void vulkan_swapchain::recreate() {
     _needs_recreate = false;
-    vkDeviceWaitIdle(_device);
-
-    // First, check which render passes have framebuffers, so we can recreate them
-    std::vector<VkRenderPass> render_passes;
-    for (const auto& [render_pass, framebuffers] : _framebuffers)
-        render_passes.push_back(render_pass);
-
-    destroy();
-
-    _state = create_swapchain(
-                 vulkan_swapchain_init {
-                     .device = _device,
-                     .surface = _surface,
-                     .def = _def,
-                     .sync_context = _sync_context,
-                     .memory_context = _memory_context,
-                     .width = _resized_extent.width,
-                     .height = _resized_extent.height,
-                 },
-                 _state.format)
-                 .get();
-
-    for (const auto& render_pass : render_passes)
-        create_framebuffers(render_pass);
-}
 
-void vulkan_swapchain::destroy() {
+    // The old swapchain is handed over to the new one, and released only after the new one exists
+    auto state = create_swapchain(
+                     vulkan_swapchain_init {
+                         .device = _device,
+                         .surface = _surface,
+                         .def = _def,
+                         .sync_context = _sync_context,
+                         .memory_context = _memory_context,
+                         .deletion_queue = _deletion_queue,
+                         .config = _config,
+                         .width = _resized_extent.width,
+                         .height = _resized_extent.height,
+                     },
+                     _state.format, _state.swapchain)
+                     .get();
+
+    release();
+    _state = state;
+
+    // Keep the render passes, whose framebuffers are rebuilt when they are next drawn to
     for (auto& [render_pass, framebuffers] : _framebuffers)
+        framebuffers.assign(_state.images.size(), VK_NULL_HANDLE);
+}
+
+void vulkan_swapchain::release() {
+    std::vector<VkFramebuffer> framebuffers;
+    for (const auto& [render_pass, render_pass_framebuffers] : _framebuffers)
+        for (const auto& framebuffer : render_pass_framebuffers)
+            if (framebuffer) framebuffers.push_back(framebuffer);
+
+    _deletion_queue.release([device = _device, &memory_context = _memory_context, state = _state, framebuffers] {
         for (const auto& framebuffer : framebuffers)
-            vkDestroyFramebuffer(_device, framebuffer, nullptr);
-    for (const auto& image_view : _state.image_views)
-        vkDestroyImageView(_device, image_view, nullptr);
-    vkDestroySwapchainKHR(_device, _state.swapchain, nullptr);
+            vkDestroyFramebuffer(device, framebuffer, nullptr);
+        for (const auto& image_view : state.image_views)
+            vkDestroyImageView(device, image_view, nullptr);
+        vkDestroySwapchainKHR(device, state.swapchain, nullptr);
 
-    _memory_context.destroy_image(_state.depth_image);
-    vkDestroyImageView(_device, _state.depth_image_view, nullptr);
+        vkDestroyImageView(device, state.depth_image_view, nullptr);
+        memory_context.destroy_image(state.depth_image);
+    });
+}
+
+VkFramebuffer vulkan_swapchain::create_framebuffer(VkRenderPass render_pass, uint32_t index) {
+    std::array<VkImageView, 2> attachments = {_state.image_views[index], _state.depth_image_view};
+    VkFramebufferCreateInfo framebuffer_info = {
+        .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+        .renderPass = render_pass,
+        .attachmentCount = (uint32_t) attachments.size(),
+        .pAttachments = attachments.data(),
+        .width = _state.extent.width,
+        .height = _state.extent.height,
+        .layers = 1,
+    };
+
+    VkFramebuffer framebuffer;
+    if (vkCreateFramebuffer(_device, &framebuffer_info, nullptr, &framebuffer) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create framebuffer");
 
-    _framebuffers.clear();
-    _state.image_views.clear();
-    _state.images.clear();
+    return framebuffer;
 }
 
 result::val<vulkan_swapchain_state> vulkan_swapchain::create_swapchain(const vulkan_swapchain_init& init,
-                                                                       VkSurfaceFormatKHR format) {
+                                                                       VkSurfaceFormatKHR format,
+                                                                       VkSwapchainKHR old_swapchain) {
     VkDevice device = init.device;
     VkSurfaceKHR surface = init.surface;
     const vulkan_device_def& def = init.def;
@@ -178,10 +194,26 @@ result::val<vulkan_swapchain_state> vulkan_swapchain::create_swapchain(const vul
     // Pick number of images
     VkSurfaceCapabilitiesKHR surface_capabilities;
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, init.surface, &surface_capabilities);
-    uint32_t min_image_count = surface_capabilities.minImageCount + 1;
+    uint32_t min_image_count = init.config.swapchain_images;
+    if (min_image_count == 0) min_image_count = surface_capabilities.minImageCount + 1;
+    min_image_count = std::max(min_image_count, surface_capabilities.minImageCount);
     if (surface_capabilities.maxImageCount > 0 && min_image_count > surface_capabilities.maxImageCount)
         min_image_count = surface_capabilities.maxImageCount;
 
+    // Pick present mode
+    uint32_t present_mode_count;
+    vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &present_mode_count, nullptr);
+    std::vector<VkPresentModeKHR> vk_present_modes(present_mode_count);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &present_mode_count, vk_present_modes.data());
+    std::vector<graphics_present_mode> supported_modes;
+    for (auto mode : {graphics_present_mode::fifo, graphics_present_mode::fifo_relaxed, graphics_present_mode::mailbox,
+                      graphics_present_mode::immediate}) {
+        if (std::find(vk_present_modes.begin(), vk_present_modes.end(), vk_present_mode(mode)) !=
+            vk_present_modes.end())
+            supported_modes.push_back(mode);
+    }
+    auto present_mode = graphics_swapchain::choose_present_mode(init.config.present_modes, supported_modes);
+
     // Create swapchain
     VkSwapchainCreateInfoKHR create_info = {
         .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
@@ -206,9 +238,9 @@ result::val<vulkan_swapchain_state> vulkan_swapchain::create_swapchain(const vul
 
     create_info.preTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
     create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    create_info.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    create_info.presentMode = vk_present_mode(present_mode);
     create_info.clipped = VK_TRUE;
-    create_info.oldSwapchain = VK_NULL_HANDLE;
+    create_info.oldSwapchain = old_swapchain;
 
     VkSwapchainKHR swapchain;
     if (vkCreateSwapchainKHR(device, &create_info, nullptr, &swapchain) != VK_SUCCESS)
@@ -242,14 +274,16 @@ result::val<vulkan_swapchain_state> vulkan_swapchain::create_swapchain(const vul
         .pQueueFamilyIndices = nullptr,
         .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
     };
-    auto depth_image = GET_OR_FORWARD(init.memory_context.create_gpu_image(image_create_info));
+    auto depth_image =
+        GET_OR_FORWARD(init.memory_context.create_gpu_image(image_create_info, vulkan_memory_kind::depth));
     auto depth_image_view =
-        GET_OR_FORWARD(create_image_view(device, depth_image, VK_FORMAT_D32_SFLOAT, VK_IMAGE_ASPECT_DEPTH_BIT));
+        GET_OR_FORWARD(create_image_view(device, depth_image.image, VK_FORMAT_D32_SFLOAT, VK_IMAGE_ASPECT_DEPTH_BIT));
 
     return result::ok(vulkan_swapchain_state {
         .swapchain = swapchain,
         .format = format,
         .extent = extent,
+        .present_mode = present_mode,
         .images = images,
         .image_views = image_views,
         .depth_image = depth_image,
@@ -257,6 +291,20 @@ result::val<vulkan_swapchain_state> vulkan_swapchain::create_swapchain(const vul
     });
 }
 
+VkPresentModeKHR vulkan_swapchain::vk_present_mode(graphics_present_mode mode) {
+    switch (mode) {
+        case graphics_present_mode::fifo:
+            return VK_PRESENT_MODE_FIFO_KHR;
+        case graphics_present_mode::fifo_relaxed:
+            return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+        case graphics_present_mode::mailbox:
+            return VK_PRESENT_MODE_MAILBOX_KHR;
+        case graphics_present_mode::immediate:
+            return VK_PRESENT_MODE_IMMEDIATE_KHR;
+    }
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
+
 result::val<VkImageView> vulkan_swapchain::create_image_view(VkDevice device, VkImage image, VkFormat format,
                                                              VkImageAspectFlags aspect_flags) {
     VkImageViewCreateInfo view_create_info = {
@@ -1,6 +1,7 @@
 #ifndef XGRAPHICS_VULKAN_SWAPCHAIN_H
 #define XGRAPHICS_VULKAN_SWAPCHAIN_H
 
+#include "vulkan_deletion_queue.h"
 #include "vulkan_device_def.h"
 #include "vulkan_memory_context.h"
 #include "vulkan_sync_context.h"
@@ -16,6 +17,8 @@ struct vulkan_swapchain_init {
     const vulkan_device_def& def;
     vulkan_sync_context& sync_context;
     vulkan_memory_context& memory_context;
+    vulkan_deletion_queue& deletion_queue;
+    const graphics_config& config;
     uint32_t width;
     uint32_t height;
 };
@@ -24,9 +27,10 @@ struct vulkan_swapchain_state {
     VkSwapchainKHR swapchain;
     VkSurfaceFormatKHR format;
     VkExtent2D extent;
+    graphics_present_mode present_mode;
     std::vector<VkImage> images;
     std::vector<VkImageView> image_views;
-    VkImage depth_image;
+    vulkan_image_allocation depth_image;
     VkImageView depth_image_view;
 };
 
@@ -36,9 +40,12 @@ class vulkan_swapchain : public graphics_swapchain {
     const vulkan_device_def& _def;
     vulkan_sync_context& _sync_context;
     vulkan_memory_context& _memory_context;
+    vulkan_deletion_queue& _deletion_queue;
+    const graphics_config& _config;
 
     vulkan_swapchain_state _state;
 
+    // Framebuffers are created on first use, so a recreation only rebuilds the ones that are drawn to
     std::unordered_map<VkRenderPass, std::vector<VkFramebuffer>> _framebuffers;
     uint32_t _current_index = 0;
     bool _needs_recreate = false;
@@ -50,7 +57,7 @@ class vulkan_swapchain : public graphics_swapchain {
 
     static result::ptr<graphics_swapchain> create(const vulkan_swapchain_init& init);
 
-    void create_framebuffers(VkRenderPass render_pass);
+    void add_render_pass(VkRenderPass render_pass);
     void destroy_framebuffers(VkRenderPass render_pass);
     void recreate_if_needed(VkResult result);
 
@@ -59,17 +66,25 @@ class vulkan_swapchain : public graphics_swapchain {
     [[nodiscard]] VkFormat format() const;
     [[nodiscard]] VkExtent2D extent() const;
     [[nodiscard]] uint32_t current_index() const;
-    [[nodiscard]] VkFramebuffer current_framebuffer(VkRenderPass render_pass) const;
+    [[nodiscard]] VkFramebuffer current_framebuffer(VkRenderPass render_pass);
+    [[nodiscard]] graphics_present_mode present_mode() const override;
+    [[nodiscard]] uint32_t image_count() const override;
 
     void swap() override;
     void resize(uint32_t width, uint32_t height) override;
 
   private:
     void recreate();
-    void destroy();
 
+    // Hands the state and every framebuffer over to the deletion queue, as frames in flight may still use them
+    void release();
+    VkFramebuffer create_framebuffer(VkRenderPass render_pass, uint32_t index);
+
+    // The old swapchain is retired, but has to be kept alive until the frames that presented from it complete
     static result::val<vulkan_swapchain_state> create_swapchain(const vulkan_swapchain_init& init,
-                                                                VkSurfaceFormatKHR format);
+                                                                VkSurfaceFormatKHR format,
+                                                                VkSwapchainKHR old_swapchain = VK_NULL_HANDLE);
+    static VkPresentModeKHR vk_present_mode(graphics_present_mode mode);
     static result::val<VkImageView> create_image_view(VkDevice device, VkImage image, VkFormat format,
                                                       VkImageAspectFlags aspect_flags);
 };
@@ -1,15 +1,18 @@
 #include "vulkan_sync_context.h"
 
+#include <algorithm>
 #include <vector>
 
-vulkan_sync_context::vulkan_sync_context(VkDevice device, const std::vector<VkFence>& gpu_wait_fences,
-                                         const std::vector<VkSemaphore>& image_available_semaphore,
-                                         const std::vector<VkSemaphore>& render_finished_semaphore,
-                                         uint32_t frames_in_flight)
+vulkan_sync_context::vulkan_sync_context(VkDevice device, const vulkan_device_functions& functions,
+                                         const vulkan_sync_context_state& state, uint32_t frames_in_flight)
     : _device(device),
-      _gpu_wait_fences(gpu_wait_fences),
-      _image_available_semaphore(image_available_semaphore),
-      _render_finished_semaphore(render_finished_semaphore),
+      _functions(functions),
+      _gpu_wait_fences(state.gpu_wait_fences),
+      _image_available_semaphore(state.image_available_semaphore),
+      _render_finished_semaphore(state.render_finished_semaphore),
+      _relay_semaphores(frames_in_flight),
+      _frame_timeline(state.frame_timeline),
+      _frame_values(frames_in_flight),
       _frames_in_flight(frames_in_flight) { }
 
 vulkan_sync_context::~vulkan_sync_context() {
@@ -19,30 +22,51 @@ vulkan_sync_context::~vulkan_sync_context() {
         vkDestroySemaphore(_device, semaphore, nullptr);
     for (auto semaphore : _render_finished_semaphore)
         vkDestroySemaphore(_device, semaphore, nullptr);
+    for (const auto& semaphores : _relay_semaphores)
+        for (auto semaphore : semaphores)
+            vkDestroySemaphore(_device, semaphore, nullptr);
+    if (_frame_timeline) vkDestroySemaphore(_device, _frame_timeline, nullptr);
 }
 
-result::ptr<vulkan_sync_context> vulkan_sync_context::create(VkDevice device, graphics_config config) {
+result::ptr<vulkan_sync_context> vulkan_sync_context::create(VkDevice device, const vulkan_device_def& def,
+                                                             const vulkan_device_functions& functions,
+                                                             graphics_config config) {
     int frames_in_flight = config.frames_in_flight;
+    vulkan_sync_context_state state;
 
-    std::vector<VkFence> gpu_wait_fences;
-    std::vector<VkSemaphore> image_available_semaphore;
-    std::vector<VkSemaphore> render_finished_semaphore;
+    VkSemaphoreCreateInfo semaphore_info = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+    };
+
+    if (def.timeline_semaphore) {
+        VkSemaphoreTypeCreateInfoKHR type_info = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR,
+            .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR,
+            .initialValue = 0,
+        };
+        VkSemaphoreCreateInfo timeline_info = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            .pNext = &type_info,
+        };
+
+        if (vkCreateSemaphore(device, &timeline_info, nullptr, &state.frame_timeline) != VK_SUCCESS)
+            return result::err("Failed to create timeline semaphore");
+    }
 
     for (int i = 0; i < frames_in_flight; i++) {
-        VkFence fence;
         VkSemaphore image_available;
         VkSemaphore render_finished;
 
-        VkFenceCreateInfo fence_info = {
-            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-        };
-
-        if (vkCreateFence(device, &fence_info, nullptr, &fence) != VK_SUCCESS)
-            return result::err("Failed to create fence");
+        if (!def.timeline_semaphore) {
+            VkFenceCreateInfo fence_info = {
+                .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+            };
 
-        VkSemaphoreCreateInfo semaphore_info = {
-            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
-        };
+            VkFence fence;
+            if (vkCreateFence(device, &fence_info, nullptr, &fence) != VK_SUCCESS)
+                return result::err("Failed to create fence");
+            state.gpu_wait_fences.push_back(fence);
+        }
 
         if (vkCreateSemaphore(device, &semaphore_info, nullptr, &image_available) != VK_SUCCESS)
             return result::err("Failed to create semaphore");
@@ -50,21 +74,81 @@ result::ptr<vulkan_sync_context> vulkan_sync_context::create(VkDevice device, gr
         if (vkCreateSemaphore(device, &semaphore_info, nullptr, &render_finished) != VK_SUCCESS)
             return result::err("Failed to create semaphore");
 
-        gpu_wait_fences.push_back(fence);
-        image_available_semaphore.push_back(image_available);
-        render_finished_semaphore.push_back(render_finished);
+        state.image_available_semaphore.push_back(image_available);
+        state.render_finished_semaphore.push_back(render_finished);
     }
 
-    return result::ok(new vulkan_sync_context(device, gpu_wait_fences, image_available_semaphore,
-                                              render_finished_semaphore, config.frames_in_flight));
+    return result::ok(new vulkan_sync_context(device, functions, state, config.frames_in_flight));
 }
 
 void vulkan_sync_context::set_current_frame(int current_frame) {
     _current_frame = current_frame;
 }
 
+void vulkan_sync_context::wait_for_frame() {
+    if (timeline()) {
+        wait_for_frame_value(_frame_values[_current_frame]);
+        return;
+    }
+
+    VkFence fence = gpu_wait_fence();
+    vkWaitForFences(_device, 1, &fence, VK_TRUE, UINT64_MAX);
+    vkResetFences(_device, 1, &fence);
+    _completed_frame_value = _frame_values[_current_frame];
+}
+
+uint64_t vulkan_sync_context::signal_frame() {
+    _frame_values[_current_frame] = ++_submitted_frame_value;
+    return _submitted_frame_value;
+}
+
+uint64_t vulkan_sync_context::completed_frame_value() {
+    if (timeline()) _functions.get_semaphore_counter_value(_device, _frame_timeline, &_completed_frame_value);
+    return _completed_frame_value;
+}
+
+uint64_t vulkan_sync_context::pending_frame_value() const {
+    return _submitted_frame_value + 1;
+}
+
+void vulkan_sync_context::wait_for_frame_value(uint64_t value) {
+    if (value <= _completed_frame_value) return;
+    if (value > _submitted_frame_value) throw std::runtime_error("Frame has not been submitted");
+
+    if (timeline()) {
+        VkSemaphoreWaitInfoKHR wait_info = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR,
+            .semaphoreCount = 1,
+            .pSemaphores = &_frame_timeline,
+            .pValues = &value,
+        };
+        _functions.wait_semaphores(_device, &wait_info, UINT64_MAX);
+        _completed_frame_value = value;
+        return;
+    }
+
+    // The fence of a slot is only reset once its frame value has completed, so the earliest slot holding the value or
+    // a later one still has its fence submitted. Frames complete in submission order, which also covers the value.
+    uint32_t slot = _frames_in_flight;
+    for (uint32_t i = 0; i < _frames_in_flight; i++) {
+        if (_frame_values[i] < value) continue;
+        if (slot == _frames_in_flight || _frame_values[i] < _frame_values[slot]) slot = i;
+    }
+
+    vkWaitForFences(_device, 1, &_gpu_wait_fences[slot], VK_TRUE, UINT64_MAX);
+    _completed_frame_value = std::max(_completed_frame_value, _frame_values[slot]);
+}
+
+bool vulkan_sync_context::timeline() const {
+    return _frame_timeline != VK_NULL_HANDLE;
+}
+
+VkSemaphore vulkan_sync_context::frame_timeline() const {
+    return _frame_timeline;
+}
+
 VkFence vulkan_sync_context::gpu_wait_fence() const {
-    return _gpu_wait_fences[_current_frame];
+    return timeline() ? VK_NULL_HANDLE : _gpu_wait_fences[_current_frame];
 }
 
 VkSemaphore vulkan_sync_context::image_available_semaphore() const {
@@ -75,6 +159,23 @@ VkSemaphore vulkan_sync_context::render_finished_semaphore() const {
     return _render_finished_semaphore[_current_frame];
 }
 
+std::vector<VkSemaphore> vulkan_sync_context::relay_semaphores(uint32_t count) {
+    // The previous submission of this frame has completed, so its relay semaphores have all been waited on
+    auto& semaphores = _relay_semaphores[_current_frame];
+    while (semaphores.size() < count) {
+        VkSemaphoreCreateInfo semaphore_info = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        };
+
+        VkSemaphore semaphore;
+        if (vkCreateSemaphore(_device, &semaphore_info, nullptr, &semaphore) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create semaphore");
+        semaphores.push_back(semaphore);
+    }
+
+    return {semaphores.begin(), semaphores.begin() + count};
+}
+
 uint32_t vulkan_sync_context::current_frame() const {
     return _current_frame;
 }
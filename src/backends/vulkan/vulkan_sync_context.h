@@ -1,34 +1,74 @@
 #ifndef XGRAPHICS_VULKAN_SYNC_CONTEXT_H
 #define XGRAPHICS_VULKAN_SYNC_CONTEXT_H
 
+#include "vulkan_device_functions.h"
+#include <atomic>
 #include <result/result.h>
 #include <vector>
 #include <vulkan/vulkan.h>
 #include <xgraphics/graphics_config.h>
 
+struct vulkan_sync_context_state {
+    std::vector<VkFence> gpu_wait_fences;
+    std::vector<VkSemaphore> image_available_semaphore;
+    std::vector<VkSemaphore> render_finished_semaphore;
+    VkSemaphore frame_timeline = VK_NULL_HANDLE;
+};
+
+// Every submitted frame gets a monotonically increasing value, which can be waited on or queried to know when the
+// work of a frame has completed. With timeline semaphores, a single semaphore is signaled with the value and replaces
+// the fence of every frame in flight.
 class vulkan_sync_context {
     VkDevice _device;
+    vulkan_device_functions _functions;
     std::vector<VkFence> _gpu_wait_fences;
     std::vector<VkSemaphore> _image_available_semaphore;
     std::vector<VkSemaphore> _render_finished_semaphore;
+    std::vector<std::vector<VkSemaphore>> _relay_semaphores;
+    VkSemaphore _frame_timeline;
+    std::vector<uint64_t> _frame_values;
+    std::atomic<uint64_t> _submitted_frame_value = 0;
+    uint64_t _completed_frame_value = 0;
     uint32_t _current_frame = 0;
     uint32_t _frames_in_flight;
 
-    explicit vulkan_sync_context(VkDevice device, const std::vector<VkFence>& gpu_wait_fences,
-                                 const std::vector<VkSemaphore>& image_available_semaphore,
-                                 const std::vector<VkSemaphore>& render_finished_semaphore, uint32_t frames_in_flight);
+    explicit vulkan_sync_context(VkDevice device, const vulkan_device_functions& functions,
+                                 const vulkan_sync_context_state& state, uint32_t frames_in_flight);
 
   public:
     vulkan_sync_context(const vulkan_sync_context&) = delete;
     ~vulkan_sync_context();
 
-    static result::ptr<vulkan_sync_context> create(VkDevice device, graphics_config config);
+    static result::ptr<vulkan_sync_context> create(VkDevice device, const vulkan_device_def& def,
+                                                   const vulkan_device_functions& functions, graphics_config config);
 
     void set_current_frame(int current_frame);
 
+    // Waits for the current frame to complete. Both modes keep the same pacing, as mapped buffer and image writes from
+    // the CPU are not versioned per frame and must not race with the GPU reading them.
+    void wait_for_frame();
+
+    // Takes the value that the submission of the current frame signals
+    [[nodiscard]] uint64_t signal_frame();
+
+    [[nodiscard]] uint64_t completed_frame_value();
+
+    // The value that the next submission signals
+    [[nodiscard]] uint64_t pending_frame_value() const;
+
+    // Throws if the value has not been submitted yet, as waiting for it would never return
+    void wait_for_frame_value(uint64_t value);
+
+    [[nodiscard]] bool timeline() const;
+    [[nodiscard]] VkSemaphore frame_timeline() const;
+
+    // Null with timeline semaphores
     [[nodiscard]] VkFence gpu_wait_fence() const;
     [[nodiscard]] VkSemaphore image_available_semaphore() const;
     [[nodiscard]] VkSemaphore render_finished_semaphore() const;
+
+    // Binary semaphores of the current frame that pass a wait on to several batches of its submission
+    [[nodiscard]] std::vector<VkSemaphore> relay_semaphores(uint32_t count);
     [[nodiscard]] uint32_t current_frame() const;
     [[nodiscard]] uint32_t frames_in_flight() const;
 };
@@ -0,0 +1,346 @@
+#include "vulkan_transfer_context.h"
+
+#include "vulkan_buffer.h"
+#include "vulkan_image.h"
+
+vulkan_transfer_context::vulkan_transfer_context(VkDevice device, VkQueue queue, VkCommandPool command_pool,
+                                                 VkQueue graphics_queue, VkCommandPool graphics_command_pool,
+                                                 const vulkan_sync_context& sync_context,
+                                                 std::unique_ptr<vulkan_staging_ring> staging_ring,
+                                                 std::unique_ptr<vulkan_readback_pool> readback_pool)
+    : _device(device),
+      _queue(queue),
+      _command_pool(command_pool),
+      _graphics_queue(graphics_queue),
+      _graphics_command_pool(graphics_command_pool),
+      _sync_context(sync_context),
+      _staging_ring(std::move(staging_ring)),
+      _readback_pool(std::move(readback_pool)),
+      _frame_semaphores(sync_context.frames_in_flight()),
+      _stream_transfers(vulkan_staging_ring::STREAM_SLOTS) { }
+
+vulkan_transfer_context::~vulkan_transfer_context() {
+    vkQueueWaitIdle(_queue);
+    vkQueueWaitIdle(_graphics_queue);
+    retire();
+
+    for (auto fence : _free_fences)
+        vkDestroyFence(_device, fence, nullptr);
+    for (auto semaphore : _free_semaphores)
+        vkDestroySemaphore(_device, semaphore, nullptr);
+    for (const auto& semaphores : _frame_semaphores)
+        for (auto semaphore : semaphores)
+            vkDestroySemaphore(_device, semaphore, nullptr);
+    vkDestroyCommandPool(_device, _command_pool, nullptr);
+    vkDestroyCommandPool(_device, _graphics_command_pool, nullptr);
+}
+
+result::ptr<vulkan_transfer_context> vulkan_transfer_context::create(VkDevice device, const vulkan_device_def& def,
+                                                                     VkQueue queue, VkQueue graphics_queue,
+                                                                     const vulkan_sync_context& sync_context,
+                                                                     vulkan_memory_context& memory_context,
+                                                                     vulkan_deletion_queue& deletion_queue) {
+    auto staging_ring =
+        GET_OR_FORWARD(vulkan_staging_ring::create(memory_context, def, sync_context.frames_in_flight()));
+    auto readback_pool = GET_OR_FORWARD(vulkan_readback_pool::create(memory_context, deletion_queue, def));
+
+    VkCommandPoolCreateInfo pool_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = def.transfer_family.value(),
+    };
+
+    VkCommandPool command_pool;
+    if (vkCreateCommandPool(device, &pool_info, nullptr, &command_pool) != VK_SUCCESS)
+        return result::err("Failed to create transfer command pool");
+
+    pool_info.queueFamilyIndex = def.graphics_family.value();
+    VkCommandPool graphics_command_pool;
+    if (vkCreateCommandPool(device, &pool_info, nullptr, &graphics_command_pool) != VK_SUCCESS)
+        return result::err("Failed to create transfer command pool");
+
+    return result::ok(new vulkan_transfer_context(device, queue, command_pool, graphics_queue, graphics_command_pool,
+                                                  sync_context, std::move(staging_ring), std::move(readback_pool)));
+}
+
+vulkan_staging_allocation vulkan_transfer_context::allocate_staging(VkDeviceSize size) {
+    return _staging_ring->allocate(size);
+}
+
+void vulkan_transfer_context::flush_staging(const vulkan_staging_allocation& allocation, VkDeviceSize size) {
+    _staging_ring->flush(allocation, size);
+}
+
+vulkan_readback_pool& vulkan_transfer_context::readback_pool() {
+    return *_readback_pool;
+}
+
+VkCommandBuffer vulkan_transfer_context::begin() {
+    return begin(_command_pool, _free_command_buffers);
+}
+
+VkCommandBuffer vulkan_transfer_context::begin_graphics() {
+    return begin(_graphics_command_pool, _free_graphics_command_buffers);
+}
+
+VkCommandBuffer vulkan_transfer_context::begin(VkCommandPool command_pool,
+                                               std::vector<VkCommandBuffer>& free_command_buffers) {
+    retire();
+
+    VkCommandBuffer command_buffer;
+    if (!free_command_buffers.empty()) {
+        command_buffer = free_command_buffers.back();
+        free_command_buffers.pop_back();
+    } else {
+        VkCommandBufferAllocateInfo alloc_info = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = command_pool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1,
+        };
+
+        if (vkAllocateCommandBuffers(_device, &alloc_info, &command_buffer) != VK_SUCCESS)
+            throw std::runtime_error("Failed to allocate transfer command buffer");
+    }
+
+    VkCommandBufferBeginInfo begin_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+
+    if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS)
+        throw std::runtime_error("Failed to begin transfer command buffer");
+
+    // Transfers no longer wait for each other on the host, so order writes and readbacks against the writes of
+    // earlier submissions
+    VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT,
+    };
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier,
+                         0, nullptr, 0, nullptr);
+
+    return command_buffer;
+}
+
+graphics_transfer_token vulkan_transfer_context::submit(VkCommandBuffer command_buffer, bool signal_graphics) {
+    return submit(command_buffer, signal_graphics, false);
+}
+
+graphics_transfer_token vulkan_transfer_context::submit_graphics(VkCommandBuffer command_buffer) {
+    return submit(command_buffer, true, true);
+}
+
+graphics_transfer_token vulkan_transfer_context::submit(VkCommandBuffer command_buffer, bool signal_graphics,
+                                                        bool graphics) {
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+        throw std::runtime_error("Failed to end transfer command buffer");
+
+    VkFence fence = acquire_fence();
+    VkSubmitInfo submit_info = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &command_buffer,
+    };
+
+    if (vkQueueSubmit(graphics ? _graphics_queue : _queue, 1, &submit_info, fence) != VK_SUCCESS)
+        throw std::runtime_error("Failed to submit transfer command buffer");
+
+    _in_flight.push_back({++_submitted_value, command_buffer, fence, graphics});
+    if (signal_graphics) (graphics ? _graphics_signal_value : _transfer_signal_value) = _submitted_value;
+    _staging_ring->track({_submitted_value});
+    return {_submitted_value};
+}
+
+graphics_transfer_token vulkan_transfer_context::stream(VkBuffer buffer, VkDeviceSize offset, const void* data,
+                                                        VkDeviceSize size) {
+    graphics_transfer_token token;
+    for (VkDeviceSize done = 0; done < size;) {
+        VkDeviceSize chunk_size = std::min(size - done, vulkan_staging_ring::STREAM_CHUNK_SIZE);
+        uint32_t slot = _next_stream_slot;
+        _next_stream_slot = (_next_stream_slot + 1) % vulkan_staging_ring::STREAM_SLOTS;
+
+        // Only blocks once every slot has a chunk in flight
+        wait(_stream_transfers[slot]);
+        auto staging = _staging_ring->stream_slot(slot);
+        memcpy(staging.data, (const uint8_t*) data + done, chunk_size);
+        _staging_ring->flush(staging, chunk_size);
+
+        VkCommandBuffer command_buffer = begin();
+        VkBufferCopy region = {.srcOffset = 0, .dstOffset = offset + done, .size = chunk_size};
+        vkCmdCopyBuffer(command_buffer, staging.buffer, buffer, 1, &region);
+
+        done += chunk_size;
+        token = submit(command_buffer, done == size);
+        _stream_transfers[slot] = token;
+    }
+
+    return token;
+}
+
+void vulkan_transfer_context::defer(vulkan_buffer* buffer) {
+    _deferred_buffers.push_back(buffer);
+}
+
+void vulkan_transfer_context::defer(vulkan_image* image) {
+    _deferred_images.push_back(image);
+}
+
+void vulkan_transfer_context::cancel_deferred(vulkan_buffer* buffer) {
+    std::erase(_deferred_buffers, buffer);
+}
+
+void vulkan_transfer_context::cancel_deferred(vulkan_image* image) {
+    std::erase(_deferred_images, image);
+}
+
+void vulkan_transfer_context::flush_deferred() {
+    if (_deferred_buffers.empty() && _deferred_images.empty()) return;
+
+    if (!_deferred_buffers.empty()) {
+        VkCommandBuffer command_buffer = begin();
+        for (auto buffer : _deferred_buffers)
+            buffer->record_deferred_writes(command_buffer);
+
+        auto token = submit(command_buffer);
+        for (auto buffer : _deferred_buffers)
+            buffer->track_transfer(token);
+    }
+
+    // Region writes keep the existing contents, so they are recorded on the graphics queue that reads the image. This
+    // orders them after earlier rendering without a queue family ownership transfer.
+    if (!_deferred_images.empty()) {
+        VkCommandBuffer command_buffer = begin_graphics();
+        for (auto image : _deferred_images)
+            image->record_deferred_writes(command_buffer);
+
+        auto token = submit_graphics(command_buffer);
+        for (auto image : _deferred_images)
+            image->track_transfer(token);
+    }
+
+    _deferred_buffers.clear();
+    _deferred_images.clear();
+}
+
+bool vulkan_transfer_context::complete(graphics_transfer_token token) {
+    if (token.value <= _completed_value) return true;
+    retire();
+    return token.value <= _completed_value;
+}
+
+void vulkan_transfer_context::wait(graphics_transfer_token token) {
+    if (complete(token)) return;
+
+    for (const auto& transfer : _in_flight) {
+        if (transfer.value > token.value) break;
+        vkWaitForFences(_device, 1, &transfer.fence, VK_TRUE, UINT64_MAX);
+    }
+
+    retire();
+}
+
+std::vector<VkSemaphore> vulkan_transfer_context::take_wait_semaphores() {
+    // A semaphore signaled by an empty submission is ordered after every earlier submission on its queue, so one per
+    // queue covers any number of transfers
+    std::vector<VkSemaphore> semaphores;
+    auto signal = [&](VkQueue queue, uint64_t value) {
+        if (value <= _completed_value) return;
+
+        VkSemaphore semaphore = acquire_semaphore();
+        VkSubmitInfo submit_info = {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .signalSemaphoreCount = 1,
+            .pSignalSemaphores = &semaphore,
+        };
+
+        if (vkQueueSubmit(queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS)
+            throw std::runtime_error("Failed to submit transfer semaphore");
+        semaphores.push_back(semaphore);
+    };
+
+    retire();
+    if (_queue == _graphics_queue) {
+        signal(_queue, std::max(_transfer_signal_value, _graphics_signal_value));
+    } else {
+        signal(_queue, _transfer_signal_value);
+        signal(_graphics_queue, _graphics_signal_value);
+    }
+    _transfer_signal_value = 0;
+    _graphics_signal_value = 0;
+
+    auto& frame_semaphores = _frame_semaphores[_sync_context.current_frame()];
+    frame_semaphores.insert(frame_semaphores.end(), semaphores.begin(), semaphores.end());
+    return semaphores;
+}
+
+void vulkan_transfer_context::begin_frame() {
+    uint32_t frame = _sync_context.current_frame();
+
+    // The graphics work that waited on these semaphores has finished, so they are unsignaled again
+    auto& frame_semaphores = _frame_semaphores[frame];
+    _free_semaphores.insert(_free_semaphores.end(), frame_semaphores.begin(), frame_semaphores.end());
+    frame_semaphores.clear();
+
+    // Transfers are not covered by the frame fence if nothing was rendered after they were submitted
+    wait(_staging_ring->last_transfer(frame));
+    _staging_ring->reset(frame);
+    _frame++;
+    _readback_pool->trim(_frame);
+}
+
+uint64_t vulkan_transfer_context::frame() const {
+    return _frame;
+}
+
+void vulkan_transfer_context::retire() {
+    // Transfers are retired in submission order, so the completed value never skips an unfinished transfer
+    while (!_in_flight.empty()) {
+        const auto& transfer = _in_flight.front();
+        if (vkGetFenceStatus(_device, transfer.fence) != VK_SUCCESS) break;
+
+        auto& free_command_buffers = transfer.graphics ? _free_graphics_command_buffers : _free_command_buffers;
+        free_command_buffers.push_back(transfer.command_buffer);
+        _free_fences.push_back(transfer.fence);
+        _completed_value = transfer.value;
+        _in_flight.pop_front();
+    }
+}
+
+VkFence vulkan_transfer_context::acquire_fence() {
+    VkFence fence;
+    if (!_free_fences.empty()) {
+        fence = _free_fences.back();
+        _free_fences.pop_back();
+        vkResetFences(_device, 1, &fence);
+        return fence;
+    }
+
+    VkFenceCreateInfo fence_info = {
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+    };
+
+    if (vkCreateFence(_device, &fence_info, nullptr, &fence) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create transfer fence");
+
+    return fence;
+}
+
+VkSemaphore vulkan_transfer_context::acquire_semaphore() {
+    VkSemaphore semaphore;
+    if (!_free_semaphores.empty()) {
+        semaphore = _free_semaphores.back();
+        _free_semaphores.pop_back();
+        return semaphore;
+    }
+
+    VkSemaphoreCreateInfo semaphore_info = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+    };
+
+    if (vkCreateSemaphore(_device, &semaphore_info, nullptr, &semaphore) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create transfer semaphore");
+
+    return semaphore;
+}
@@ -0,0 +1,117 @@
+#ifndef XGRAPHICS_VULKAN_TRANSFER_CONTEXT_H
+#define XGRAPHICS_VULKAN_TRANSFER_CONTEXT_H
+
+#include "vulkan_device_def.h"
+#include "vulkan_memory_context.h"
+#include "vulkan_readback_pool.h"
+#include "vulkan_staging_ring.h"
+#include "vulkan_sync_context.h"
+#include <deque>
+#include <result/result.h>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <xgraphics/interfaces/graphics_transfer.h>
+
+class vulkan_buffer;
+class vulkan_image;
+
+struct vulkan_transfer {
+    uint64_t value;
+    VkCommandBuffer command_buffer;
+    VkFence fence;
+    bool graphics;
+};
+
+// Records and submits one-shot transfer command buffers without blocking the caller. Every submission gets a
+// monotonically increasing value, and the next graphics submission waits on a semaphore signaled after them. Work that
+// needs a graphics capable queue, such as blits, is recorded from a separate pool and submitted to the graphics queue,
+// but is otherwise tracked the same way.
+class vulkan_transfer_context {
+    VkDevice _device;
+    VkQueue _queue;
+    VkCommandPool _command_pool;
+    VkQueue _graphics_queue;
+    VkCommandPool _graphics_command_pool;
+    const vulkan_sync_context& _sync_context;
+    std::unique_ptr<vulkan_staging_ring> _staging_ring;
+    std::unique_ptr<vulkan_readback_pool> _readback_pool;
+
+    std::deque<vulkan_transfer> _in_flight;
+    std::vector<VkCommandBuffer> _free_command_buffers;
+    std::vector<VkCommandBuffer> _free_graphics_command_buffers;
+    std::vector<VkFence> _free_fences;
+    std::vector<VkSemaphore> _free_semaphores;
+    std::vector<std::vector<VkSemaphore>> _frame_semaphores;
+    std::vector<vulkan_buffer*> _deferred_buffers;
+    std::vector<vulkan_image*> _deferred_images;
+    std::vector<graphics_transfer_token> _stream_transfers;
+    uint32_t _next_stream_slot = 0;
+    uint64_t _frame = 0;
+    uint64_t _submitted_value = 0;
+    uint64_t _completed_value = 0;
+
+    // Last submission on each queue that the next frame must wait for
+    uint64_t _transfer_signal_value = 0;
+    uint64_t _graphics_signal_value = 0;
+
+    explicit vulkan_transfer_context(VkDevice device, VkQueue queue, VkCommandPool command_pool,
+                                     VkQueue graphics_queue, VkCommandPool graphics_command_pool,
+                                     const vulkan_sync_context& sync_context,
+                                     std::unique_ptr<vulkan_staging_ring> staging_ring,
+                                     std::unique_ptr<vulkan_readback_pool> readback_pool);
+
+  public:
+    vulkan_transfer_context(const vulkan_transfer_context&) = delete;
+    ~vulkan_transfer_context();
+
+    static result::ptr<vulkan_transfer_context> create(VkDevice device, const vulkan_device_def& def, VkQueue queue,
+                                                       VkQueue graphics_queue, const vulkan_sync_context& sync_context,
+                                                       vulkan_memory_context& memory_context,
+                                                       vulkan_deletion_queue& deletion_queue);
+
+    // Staging memory stays valid until the frame it was allocated in comes around again
+    [[nodiscard]] vulkan_staging_allocation allocate_staging(VkDeviceSize size);
+    void flush_staging(const vulkan_staging_allocation& allocation, VkDeviceSize size);
+
+    [[nodiscard]] vulkan_readback_pool& readback_pool();
+
+    [[nodiscard]] VkCommandBuffer begin();
+
+    // Only submissions that signal graphics are waited on by the next frame. The others are still covered by it, as
+    // long as a later submission on the same queue does signal.
+    graphics_transfer_token submit(VkCommandBuffer command_buffer, bool signal_graphics = true);
+
+    [[nodiscard]] VkCommandBuffer begin_graphics();
+    graphics_transfer_token submit_graphics(VkCommandBuffer command_buffer);
+
+    // Copies a write of any size through the stream slots, one chunk per submission. The copy of one chunk overlaps
+    // with filling the next, and staging memory stays bounded however large the write is.
+    graphics_transfer_token stream(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size);
+
+    // Buffers and images with deferred writes are uploaded together in one submission
+    void defer(vulkan_buffer* buffer);
+    void defer(vulkan_image* image);
+    void cancel_deferred(vulkan_buffer* buffer);
+    void cancel_deferred(vulkan_image* image);
+    void flush_deferred();
+
+    [[nodiscard]] bool complete(graphics_transfer_token token);
+    void wait(graphics_transfer_token token);
+
+    // At most one semaphore per queue, signaled after every transfer that the graphics queue has not waited on yet.
+    // Transfers that the host has already waited for need none. They are recycled once their frame comes around again.
+    [[nodiscard]] std::vector<VkSemaphore> take_wait_semaphores();
+    void begin_frame();
+
+    // Counts the frames begun so far, which tells whether staging memory allocated earlier is still valid
+    [[nodiscard]] uint64_t frame() const;
+
+  private:
+    VkCommandBuffer begin(VkCommandPool command_pool, std::vector<VkCommandBuffer>& free_command_buffers);
+    graphics_transfer_token submit(VkCommandBuffer command_buffer, bool signal_graphics, bool graphics);
+    void retire();
+    VkFence acquire_fence();
+    VkSemaphore acquire_semaphore();
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include "vulkan_transient_allocator.h"
+
+vulkan_transient_allocator::vulkan_transient_allocator(const vulkan_transient_allocator_init& init)
+    : _device(init.device),
+      _def(init.def),
+      _memory_context(init.memory_context),
+      _transfer_context(init.transfer_context),
+      _deletion_queue(init.deletion_queue),
+      _regions(init.frames_in_flight) { }
+
+result::ptr<vulkan_transient_allocator>
+vulkan_transient_allocator::create(const vulkan_transient_allocator_init& init) {
+    auto allocator = std::unique_ptr<vulkan_transient_allocator>(new vulkan_transient_allocator(init));
+    for (auto& region : allocator->_regions)
+        region.push_back({GET_OR_FORWARD(allocator->create_chunk(CHUNK_SIZE)), CHUNK_SIZE, 0});
+
+    return result::ok(allocator.release());
+}
+
+graphics_transient_allocation vulkan_transient_allocator::allocate(buffer_usage_flags usage, uint64_t size) {
+    auto& chunks = _regions[_current_region];
+
+    uint32_t alignment = ALIGNMENT;
+    if (usage & (int) buffer_usage::uniform)
+        alignment = std::max(alignment, (uint32_t) _def.min_uniform_buffer_offset_alignment);
+
+    auto* chunk = &chunks.back();
+    uint64_t offset = (chunk->offset + alignment - 1) / alignment * alignment;
+    if (offset + size > chunk->size) {
+        // Grow the region, it will be merged into a single chunk the next time it is reset
+        uint64_t chunk_size = std::max(size, CHUNK_SIZE);
+        auto buffer = create_chunk(chunk_size);
+        if (!buffer.is_ok()) throw std::runtime_error("Failed to grow transient memory");
+
+        chunks.push_back({std::move(buffer.get()), chunk_size, 0});
+        chunk = &chunks.back();
+        offset = 0;
+    }
+
+    chunk->offset = offset + size;
+    auto* buffer = (const vulkan_buffer*) chunk->buffer.get();
+    return {
+        .buffer = buffer,
+        .offset = offset,
+        .size = size,
+        .data = (uint8_t*) buffer->mapped_data() + offset,
+    };
+}
+
+void vulkan_transient_allocator::flush() {
+    for (const auto& chunk : _regions[_current_region])
+        if (chunk.offset > 0) ((const vulkan_buffer*) chunk.buffer.get())->flush(0, chunk.offset);
+}
+
+void vulkan_transient_allocator::reset(uint32_t region) {
+    _current_region = region;
+    auto& chunks = _regions[region];
+
+    if (chunks.size() > 1) {
+        uint64_t total_size = 0;
+        for (const auto& chunk : chunks)
+            total_size += chunk.size;
+        chunks.clear();
+
+        auto buffer = create_chunk(total_size);
+        if (!buffer.is_ok()) throw std::runtime_error("Failed to resize transient memory");
+        chunks.push_back({std::move(buffer.get()), total_size, 0});
+    }
+
+    chunks.back().offset = 0;
+}
+
+result::ptr<graphics_buffer> vulkan_transient_allocator::create_chunk(uint64_t size) {
+    vulkan_buffer_init init = {
+        .device = _device,
+        .usage = buffer_usage::vertex | buffer_usage::index | buffer_usage::uniform | buffer_usage::indirect,
+        .size = size,
+        .def = _def,
+        .memory_context = _memory_context,
+        .transfer_context = _transfer_context,
+        .deletion_queue = _deletion_queue,
+        .mapped = true,
+    };
+
+    return vulkan_buffer::create(init);
+}
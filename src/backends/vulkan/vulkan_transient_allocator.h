@@ -0,0 +1,57 @@
+#ifndef XGRAPHICS_VULKAN_TRANSIENT_ALLOCATOR_H
+#define XGRAPHICS_VULKAN_TRANSIENT_ALLOCATOR_H
+
+#include "vulkan_buffer.h"
+#include <memory>
+#include <result/result.h>
+#include <vector>
+#include <xgraphics/interfaces/graphics_transient.h>
+
+struct vulkan_transient_allocator_init {
+    VkDevice device;
+    const vulkan_device_def& def;
+    vulkan_memory_context& memory_context;
+    vulkan_transfer_context& transfer_context;
+    vulkan_deletion_queue& deletion_queue;
+    uint32_t frames_in_flight;
+};
+
+struct vulkan_transient_chunk {
+    std::unique_ptr<graphics_buffer> buffer;
+    uint64_t size;
+    uint64_t offset;
+};
+
+// Per-frame linear allocator for data that is rewritten every frame. There is one region per frame in flight, each
+// a persistently mapped buffer that allocations are bumped from. A region grows by adding chunks when it runs out of
+// space, and is reset, with its chunks merged into one, once the frame that last used it has completed.
+class vulkan_transient_allocator {
+    VkDevice _device;
+    const vulkan_device_def& _def;
+    vulkan_memory_context& _memory_context;
+    vulkan_transfer_context& _transfer_context;
+    vulkan_deletion_queue& _deletion_queue;
+    std::vector<std::vector<vulkan_transient_chunk>> _regions;
+    uint32_t _current_region = 0;
+
+    explicit vulkan_transient_allocator(const vulkan_transient_allocator_init& init);
+
+  public:
+    static constexpr uint64_t CHUNK_SIZE = 1024 * 1024;
+    static constexpr uint32_t ALIGNMENT = 16;
+
+    vulkan_transient_allocator(const vulkan_transient_allocator&) = delete;
+
+    static result::ptr<vulkan_transient_allocator> create(const vulkan_transient_allocator_init& init);
+
+    [[nodiscard]] graphics_transient_allocation allocate(buffer_usage_flags usage, uint64_t size);
+
+    // Makes the data written this frame visible to the device, called before the frame is submitted
+    void flush();
+    void reset(uint32_t region);
+
+  private:
+    result::ptr<graphics_buffer> create_chunk(uint64_t size);
+};
+
+#endif
@@ -1,17 +1,21 @@
 #include "vulkan_uniform_buffer.h"
 vulkan_uniform_buffer::vulkan_uniform_buffer(const shader_variable_type& type, uint32_t size, VkDevice device,
                                              vulkan_sync_context* sync_context, vulkan_memory_context* memory_context,
-                                             const std::vector<vulkan_uniform_buffer_buffer>& buffers)
+                                             vulkan_deletion_queue* deletion_queue,
+                                             const std::vector<vulkan_buffer_allocation>& buffers)
     : graphics_uniform_buffer(type, size),
       _device(device),
       _sync_context(sync_context),
       _memory_context(memory_context),
+      _deletion_queue(deletion_queue),
       _buffers(buffers) { }
 
 vulkan_uniform_buffer::~vulkan_uniform_buffer() {
-    for (auto buffer : _buffers) {
-        _memory_context->destroy_buffer(buffer.buffer);
-    }
+    _deletion_queue->release([memory_context = _memory_context, buffers = _buffers] {
+        for (auto buffer : buffers) {
+            memory_context->destroy_buffer(buffer);
+        }
+    });
 }
 
 void vulkan_uniform_buffer::set_data(const shader_variable_type& type, uint32_t offset, uint32_t size,
@@ -22,8 +26,9 @@ void vulkan_uniform_buffer::set_data(const shader_variable_type& type, uint32_t
 
 result::ptr<graphics_uniform_buffer> vulkan_uniform_buffer::create(const shader_variable_type& type, VkDevice device,
                                                                    vulkan_sync_context& sync_context,
-                                                                   vulkan_memory_context& memory_context) {
-    std::vector<vulkan_uniform_buffer_buffer> buffers;
+                                                                   vulkan_memory_context& memory_context,
+                                                                   vulkan_deletion_queue& deletion_queue) {
+    std::vector<vulkan_buffer_allocation> buffers;
 
     VkDeviceSize buffer_size = type.size;
     VkBufferCreateInfo buffer_info = {
@@ -34,12 +39,13 @@ result::ptr<graphics_uniform_buffer> vulkan_uniform_buffer::create(const shader_
     };
 
     for (int i = 0; i < sync_context.frames_in_flight(); i++) {
-        auto buffer = GET_OR_FORWARD(memory_context.create_mapped_buffer(buffer_info));
-        auto mapped_data = memory_context.map_buffer(buffer);
-        buffers.push_back({buffer, mapped_data});
+        auto buffer =
+            GET_OR_FORWARD(memory_context.create_mapped_buffer(buffer_info, vulkan_memory_kind::uniform_buffer));
+        buffers.push_back(buffer);
     }
 
-    return result::ok(new vulkan_uniform_buffer(type, buffer_size, device, &sync_context, &memory_context, buffers));
+    return result::ok(new vulkan_uniform_buffer(type, buffer_size, device, &sync_context, &memory_context,
+                                                &deletion_queue, buffers));
 }
 
 VkBuffer vulkan_uniform_buffer::buffer(uint32_t frame) const {
@@ -1,24 +1,21 @@
 #ifndef XGRAPHICS_VULKAN_UNIFORM_BUFFER_H
 #define XGRAPHICS_VULKAN_UNIFORM_BUFFER_H
 
+#include "vulkan_deletion_queue.h"
 #include "vulkan_memory_context.h"
 #include "vulkan_sync_context.h"
 #include <xgraphics/interfaces/graphics_uniform_buffer.h>
 
-struct vulkan_uniform_buffer_buffer {
-    VkBuffer buffer;
-    void* mapped_data;
-};
-
 class vulkan_uniform_buffer : public graphics_uniform_buffer {
     VkDevice _device;
     vulkan_sync_context* _sync_context;
     vulkan_memory_context* _memory_context;
-    std::vector<vulkan_uniform_buffer_buffer> _buffers;
+    vulkan_deletion_queue* _deletion_queue;
+    std::vector<vulkan_buffer_allocation> _buffers;
 
     vulkan_uniform_buffer(const shader_variable_type& type, uint32_t size, VkDevice device,
                           vulkan_sync_context* sync_context, vulkan_memory_context* memory_context,
-                          const std::vector<vulkan_uniform_buffer_buffer>& buffers);
+                          vulkan_deletion_queue* deletion_queue, const std::vector<vulkan_buffer_allocation>& buffers);
 
   protected:
     void set_data(const shader_variable_type& type, uint32_t offset, uint32_t size, const void* data) override;
@@ -28,7 +25,8 @@ class vulkan_uniform_buffer : public graphics_uniform_buffer {
 
     static result::ptr<graphics_uniform_buffer> create(const shader_variable_type& type, VkDevice device,
                                                        vulkan_sync_context& sync_context,
-                                                       vulkan_memory_context& memory_context);
+                                                       vulkan_memory_context& memory_context,
+                                                       vulkan_deletion_queue& deletion_queue);
 
     [[nodiscard]] VkBuffer buffer(uint32_t frame) const;
 };
@@ -0,0 +1,131 @@
+#include "vulkan_upload_batch.h"
+#include <algorithm>
+#include <unordered_set>
+
+vulkan_upload_batch::vulkan_upload_batch(vulkan_transfer_context& transfer_context)
+    : _transfer_context(transfer_context) { }
+
+result::ptr<graphics_upload_batch> vulkan_upload_batch::create(vulkan_transfer_context& transfer_context) {
+    return result::ok(new vulkan_upload_batch(transfer_context));
+}
+
+void vulkan_upload_batch::record_write(graphics_buffer& buffer, const void* data, uint64_t size) {
+    auto& native_buffer = (vulkan_buffer&) buffer;
+    if (native_buffer.host_visible()) {
+        native_buffer.write(data, size);
+        return;
+    }
+
+    // Streaming would split the write across several submissions, while the batch submits everything at once
+    if (size > vulkan_staging_ring::STREAM_CHUNK_SIZE)
+        throw std::runtime_error("Buffer write is too large for an upload batch, write the buffer directly instead");
+
+    if (_buffer_uploads.empty() && _image_uploads.empty()) _frame = _transfer_context.frame();
+    // Deferred writes are flushed after the batch, and must not bring back older data
+    native_buffer.update_dirty_ranges(0, data, size);
+
+    auto staging = _transfer_context.allocate_staging(size);
+    memcpy(staging.data, data, size);
+    _transfer_context.flush_staging(staging, size);
+
+    VkBufferCopy region = {.srcOffset = staging.offset, .size = size};
+    _buffer_uploads.push_back({&native_buffer, staging.buffer, region});
+}
+
+void vulkan_upload_batch::record_write(graphics_image& image, const void* data, uint64_t size) {
+    if (_buffer_uploads.empty() && _image_uploads.empty()) _frame = _transfer_context.frame();
+    auto staging = _transfer_context.allocate_staging(size);
+    memcpy(staging.data, data, size);
+    _transfer_context.flush_staging(staging, size);
+
+    // A later write replaces the whole image, so the earlier copy and its barriers are dropped
+    vulkan_image_upload upload = {(vulkan_image*) &image, staging.buffer, staging.offset};
+    auto it = std::find_if(_image_uploads.begin(), _image_uploads.end(),
+                           [&](const auto& pending) { return pending.image == upload.image; });
+    if (it != _image_uploads.end()) *it = upload;
+    else _image_uploads.push_back(upload);
+}
+
+graphics_transfer_token vulkan_upload_batch::submit_writes() {
+    if (_buffer_uploads.empty() && _image_uploads.empty()) return {};
+    if (_frame != _transfer_context.frame())
+        throw std::runtime_error("Upload batch must be submitted in the frame it was written in");
+
+    // Mipmapped images are blitted, which the transfer queue might not support
+    std::vector<vulkan_image_upload> image_uploads;
+    std::vector<vulkan_image_upload> mipmapped_image_uploads;
+    for (const auto& upload : _image_uploads)
+        (upload.image->generates_mipmaps() ? mipmapped_image_uploads : image_uploads).push_back(upload);
+
+    graphics_transfer_token token;
+    if (!_buffer_uploads.empty() || !image_uploads.empty()) {
+        VkCommandBuffer command_buffer = _transfer_context.begin();
+
+        // Every write starts at the beginning of the buffer, so a buffer written again waits for the earlier copies
+        std::unordered_set<vulkan_buffer*> written_buffers;
+        for (const auto& upload : _buffer_uploads) {
+            if (!written_buffers.insert(upload.buffer).second) {
+                VkMemoryBarrier barrier = {
+                    .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                    .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                    .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                };
+                vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                                     1, &barrier, 0, nullptr, 0, nullptr);
+                written_buffers = {upload.buffer};
+            }
+            vkCmdCopyBuffer(command_buffer, upload.staging_buffer, upload.buffer->buffer(), 1, &upload.region);
+        }
+
+        record_image_uploads(command_buffer, image_uploads);
+        token = _transfer_context.submit(command_buffer);
+    }
+
+    if (!mipmapped_image_uploads.empty()) {
+        VkCommandBuffer graphics_command_buffer = _transfer_context.begin_graphics();
+        record_image_uploads(graphics_command_buffer, mipmapped_image_uploads);
+        token = _transfer_context.submit_graphics(graphics_command_buffer);
+    }
+
+    for (const auto& upload : _buffer_uploads)
+        upload.buffer->track_transfer(token);
+    for (const auto& upload : _image_uploads)
+        upload.image->track_transfer(token);
+
+    _buffer_uploads.clear();
+    _image_uploads.clear();
+    return token;
+}
+
+void vulkan_upload_batch::record_image_uploads(VkCommandBuffer command_buffer,
+                                               const std::vector<vulkan_image_upload>& uploads) {
+    if (uploads.empty()) return;
+
+    // Transition every image at once, before and after all of the copies
+    std::vector<VkImageMemoryBarrier> barriers;
+    for (const auto& upload : uploads)
+        barriers.push_back(upload.image->transfer_dst_barrier());
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0,
+                         nullptr, 0, nullptr, (uint32_t) barriers.size(), barriers.data());
+
+    for (const auto& upload : uploads) {
+        VkBufferImageCopy region = upload.image->copy_region(upload.staging_offset);
+        vkCmdCopyBufferToImage(command_buffer, upload.staging_buffer, upload.image->image(),
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    }
+
+    barriers.clear();
+    for (const auto& upload : uploads) {
+        if (upload.image->generates_mipmaps()) upload.image->record_mipmaps(command_buffer);
+        else barriers.push_back(upload.image->shader_read_barrier());
+        upload.image->track_write(0);
+    }
+
+    if (barriers.empty()) return;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0,
+                         nullptr, 0, nullptr, (uint32_t) barriers.size(), barriers.data());
+}
+
+void vulkan_upload_batch::wait_for_writes(graphics_transfer_token token) {
+    _transfer_context.wait(token);
+}
@@ -0,0 +1,50 @@
+#ifndef XGRAPHICS_VULKAN_UPLOAD_BATCH_H
+#define XGRAPHICS_VULKAN_UPLOAD_BATCH_H
+
+#include "vulkan_buffer.h"
+#include "vulkan_image.h"
+#include "vulkan_transfer_context.h"
+#include <result/result.h>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <xgraphics/interfaces/graphics_upload_batch.h>
+
+struct vulkan_buffer_upload {
+    vulkan_buffer* buffer;
+    VkBuffer staging_buffer;
+    VkBufferCopy region;
+};
+
+struct vulkan_image_upload {
+    vulkan_image* image;
+    VkBuffer staging_buffer;
+    VkDeviceSize staging_offset;
+};
+
+// Data is copied into staging memory as it is written, and every copy is recorded into a single command buffer when
+// the batch is submitted. Staging memory belongs to the current frame, so the batch must be submitted before the
+// device advances to the next one. Writes to the same buffer are applied in order, and only the last write to an image
+// is kept, as it replaces the whole image.
+// Buffer writes larger than STREAM_CHUNK_SIZE are rejected, as they can only be streamed in several submissions.
+class vulkan_upload_batch : public graphics_upload_batch {
+    vulkan_transfer_context& _transfer_context;
+    std::vector<vulkan_buffer_upload> _buffer_uploads;
+    std::vector<vulkan_image_upload> _image_uploads;
+    uint64_t _frame = 0;
+
+    explicit vulkan_upload_batch(vulkan_transfer_context& transfer_context);
+
+  protected:
+    void record_write(graphics_buffer& buffer, const void* data, uint64_t size) override;
+    void record_write(graphics_image& image, const void* data, uint64_t size) override;
+    graphics_transfer_token submit_writes() override;
+    void wait_for_writes(graphics_transfer_token token) override;
+
+  public:
+    static result::ptr<graphics_upload_batch> create(vulkan_transfer_context& transfer_context);
+
+  private:
+    static void record_image_uploads(VkCommandBuffer command_buffer, const std::vector<vulkan_image_upload>& uploads);
+};
+
+#endif
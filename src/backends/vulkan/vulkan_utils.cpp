@@ -25,3 +25,15 @@ result::val<VkDescriptorType> vulkan_utils::vk_descriptor_type(const shader_vari
             return result::err("Unsupported descriptor type");
     }
 }
+
+bool vulkan_utils::instance_extension_supported(const char* name) {
+    uint32_t extension_count = 0;
+    vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, nullptr);
+    std::vector<VkExtensionProperties> extensions(extension_count);
+    vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, extensions.data());
+
+    for (const auto& extension : extensions)
+        if (extension.extensionName == std::string(name)) return true;
+
+    return false;
+}
@@ -10,6 +10,8 @@ class vulkan_utils {
     // TODO: Put more conversion functions here
     static result::val<VkShaderStageFlagBits> vk_shader_stage(const shader_kind& kind);
     static result::val<VkDescriptorType> vk_descriptor_type(const shader_variable_type& type);
+
+    static bool instance_extension_supported(const char* name);
 };
 
 #endif
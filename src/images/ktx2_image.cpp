@@ -0,0 +1,237 @@
+#include "xgraphics/images/ktx2_image.h"
+#include <algorithm>
+#include <cstring>
+#include <optional>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const uint8_t KTX2_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+struct ktx2_header {
+    uint8_t identifier[12];
+    uint32_t vk_format;
+    uint32_t type_size;
+    uint32_t pixel_width;
+    uint32_t pixel_height;
+    uint32_t pixel_depth;
+    uint32_t layer_count;
+    uint32_t face_count;
+    uint32_t level_count;
+    uint32_t supercompression_scheme;
+    uint32_t dfd_byte_offset;
+    uint32_t dfd_byte_length;
+    uint32_t kvd_byte_offset;
+    uint32_t kvd_byte_length;
+    uint64_t sgd_byte_offset;
+    uint64_t sgd_byte_length;
+};
+
+struct ktx2_level_index {
+    uint64_t byte_offset;
+    uint64_t byte_length;
+    uint64_t uncompressed_byte_length;
+};
+
+// Files store VkFormat values, which are matched by value so that loading does not depend on the Vulkan headers
+static std::optional<graphics_image_format> ktx2_format(uint32_t vk_format) {
+    switch (vk_format) {
+        case 37:
+            return graphics_image_format::rgba_8_unorm;
+        case 43:
+            return graphics_image_format::rgba_8_srgb;
+        case 133:
+            return graphics_image_format::bc1_unorm;
+        case 134:
+            return graphics_image_format::bc1_srgb;
+        case 137:
+            return graphics_image_format::bc3_unorm;
+        case 138:
+            return graphics_image_format::bc3_srgb;
+        case 139:
+            return graphics_image_format::bc4_unorm;
+        case 141:
+            return graphics_image_format::bc5_unorm;
+        case 145:
+            return graphics_image_format::bc7_unorm;
+        case 146:
+            return graphics_image_format::bc7_srgb;
+        case 151:
+            return graphics_image_format::etc2_rgba_8_unorm;
+        case 152:
+            return graphics_image_format::etc2_rgba_8_srgb;
+        case 157:
+            return graphics_image_format::astc_4x4_unorm;
+        case 158:
+            return graphics_image_format::astc_4x4_srgb;
+        default:
+            return std::nullopt;
+    }
+}
+
+#ifdef _WIN32
+// Without mmap, the whole file is read into memory that lives as long as the image
+static void* map_file(const std::string& path, uint64_t& size) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return nullptr;
+
+    size = (uint64_t) file.tellg();
+    auto data = new uint8_t[size];
+    file.seekg(0);
+    if (!file.read((char*) data, (std::streamsize) size)) {
+        delete[] data;
+        return nullptr;
+    }
+    return data;
+}
+
+static void unmap_file(void* mapping, uint64_t) {
+    delete[] (uint8_t*) mapping;
+}
+#else
+static void* map_file(const std::string& path, uint64_t& size) {
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) return nullptr;
+
+    struct stat file_stat = {};
+    if (fstat(file, &file_stat) != 0) {
+        close(file);
+        return nullptr;
+    }
+
+    // The mapping stays valid after the file is closed. Empty files cannot be mapped, and are rejected by the caller.
+    size = (uint64_t) file_stat.st_size;
+    void* mapping = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+    close(file);
+    return mapping == MAP_FAILED ? nullptr : mapping;
+}
+
+static void unmap_file(void* mapping, uint64_t size) {
+    munmap(mapping, size);
+}
+#endif
+
+ktx2_image::ktx2_image(void* mapping, uint64_t mapping_size, const graphics_image_init& init,
+                       std::vector<ktx2_level> levels)
+    : _mapping(mapping), _mapping_size(mapping_size), _init(init), _levels(std::move(levels)) { }
+
+ktx2_image::~ktx2_image() {
+    unmap_file(_mapping, _mapping_size);
+}
+
+result::ptr<ktx2_image> ktx2_image::open(const std::string& path) {
+    uint64_t mapping_size = 0;
+    void* mapping = map_file(path, mapping_size);
+    if (!mapping) return result::err("Failed to read KTX2 file");
+
+    auto fail = [&](const char* message) {
+        unmap_file(mapping, mapping_size);
+        return result::err(message);
+    };
+    if (mapping_size < sizeof(ktx2_header)) return fail("Failed to read KTX2 file");
+
+    auto bytes = (const uint8_t*) mapping;
+    ktx2_header header;
+    memcpy(&header, bytes, sizeof(header));
+    if (memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) return fail("Not a KTX2 file");
+
+    auto format = ktx2_format(header.vk_format);
+    if (!format.has_value()) return fail("Unsupported KTX2 image format");
+    if (header.supercompression_scheme != 0) return fail("Supercompressed KTX2 files are not supported");
+
+    // Counts of 0 mean the file is not an array or a 3D image
+    graphics_image_init init = {.width = header.pixel_width, .height = header.pixel_height, .format = *format};
+    if (header.face_count == 6) {
+        if (header.layer_count > 0) return fail("KTX2 cube map arrays are not supported");
+        init.type = graphics_image_type::cube;
+    } else if (header.face_count != 1) {
+        return fail("KTX2 file has an invalid face count");
+    } else if (header.layer_count > 0) {
+        if (header.pixel_depth > 0) return fail("KTX2 3D image arrays are not supported");
+        init.type = graphics_image_type::image_2d_array;
+        init.layers = header.layer_count;
+    } else if (header.pixel_depth > 0) {
+        init.type = graphics_image_type::image_3d;
+        init.depth = header.pixel_depth;
+    }
+    if (!graphics_image::valid(init)) return fail("KTX2 image size does not fit its type");
+
+    // A level count of 0 asks for the mip chain to be generated, which compressed formats cannot be
+    init.mip_levels = std::max(header.level_count, 1u);
+    if (init.mip_levels > graphics_image::mip_level_count(init.width, init.height, std::max(init.depth, 1u)))
+        return fail("KTX2 file has too many mip levels");
+
+    uint64_t level_index_offset = sizeof(ktx2_header);
+    if (level_index_offset + init.mip_levels * sizeof(ktx2_level_index) > mapping_size)
+        return fail("KTX2 level index is truncated");
+
+    // Layers and faces of a level are stored one after another, as images expect them to be written
+    auto info = graphics_image::format_info(*format);
+    uint32_t layers = init.type == graphics_image_type::cube ? 6 : std::max(init.layers, 1u);
+    std::vector<ktx2_level> levels;
+    for (uint32_t i = 0; i < init.mip_levels; i++) {
+        ktx2_level_index index;
+        memcpy(&index, bytes + level_index_offset + i * sizeof(ktx2_level_index), sizeof(index));
+
+        uint64_t blocks_wide = (std::max(init.width >> i, 1u) + info.block_width - 1) / info.block_width;
+        uint64_t blocks_high = (std::max(init.height >> i, 1u) + info.block_height - 1) / info.block_height;
+        uint64_t size = blocks_wide * blocks_high * info.block_size * std::max(init.depth >> i, 1u) * layers;
+        if (index.byte_length < size || index.byte_offset > mapping_size || size > mapping_size - index.byte_offset)
+            return fail("KTX2 level data is truncated");
+
+        levels.push_back({bytes + index.byte_offset, size});
+    }
+
+    return result::ok(new ktx2_image(mapping, mapping_size, init, std::move(levels)));
+}
+
+graphics_image_format ktx2_image::format() const {
+    return _init.format;
+}
+
+graphics_image_type ktx2_image::type() const {
+    return _init.type;
+}
+
+uint32_t ktx2_image::width() const {
+    return _init.width;
+}
+
+uint32_t ktx2_image::height() const {
+    return _init.height;
+}
+
+uint32_t ktx2_image::depth() const {
+    return std::max(_init.depth, 1u);
+}
+
+uint32_t ktx2_image::layers() const {
+    return _init.type == graphics_image_type::cube ? 6 : std::max(_init.layers, 1u);
+}
+
+uint32_t ktx2_image::mip_levels() const {
+    return (uint32_t) _levels.size();
+}
+
+const ktx2_level& ktx2_image::level(uint32_t mip_level) const {
+    return _levels[mip_level];
+}
+
+result::ptr<graphics_image> ktx2_image::upload(graphics_device& device) const {
+    if (!device.image_format_supported(_init.format))
+        return result::err("KTX2 image format is not supported by the device");
+
+    auto image = GET_OR_FORWARD(device.create_image(_init));
+
+    for (uint32_t i = 0; i < mip_levels(); i++)
+        image->write_level_async(i, _levels[i].data, _levels[i].size);
+
+    image->make_immutable();
+    return result::ok(image.release());
+}
@@ -1,11 +1,31 @@
 #include "xgraphics/interfaces/graphics_buffer.h"
 
-graphics_buffer::graphics_buffer(buffer_usage_flags usage, uint32_t size) : _usage(usage), _size(size) { }
+graphics_buffer::graphics_buffer(buffer_usage_flags usage, uint64_t size) : _usage(usage), _size(size) { }
 
 buffer_usage_flags graphics_buffer::usage() const {
     return _usage;
 }
 
-uint32_t graphics_buffer::size() const {
+uint64_t graphics_buffer::size() const {
     return _size;
 }
+
+bool graphics_buffer::immutable() const {
+    return _immutable;
+}
+
+void graphics_buffer::make_immutable() {
+    _immutable = true;
+}
+
+void graphics_buffer::write(const void* data, uint64_t size) {
+    write(0, data, size);
+}
+
+graphics_transfer_token graphics_buffer::write_async(const void* data, uint64_t size) {
+    return write_async(0, data, size);
+}
+
+std::unique_ptr<graphics_readback> graphics_buffer::read_async() {
+    return read_async(0, size());
+}
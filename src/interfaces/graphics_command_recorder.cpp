@@ -0,0 +1,30 @@
+#include "xgraphics/interfaces/graphics_command_recorder.h"
+#include <stdexcept>
+
+void graphics_command_recorder::bind_vertex_buffer(const graphics_buffer& buffer, uint64_t offset, int index) {
+    if (index < 0) throw std::runtime_error("Vertex buffer index is out of range");
+    graphics_vertex_buffer_binding binding = {&buffer, offset};
+    bind_vertex_buffers(index, {&binding, 1});
+}
+
+void graphics_command_recorder::draw(uint32_t vertex_start, uint32_t vertex_count) {
+    draw(vertex_start, vertex_count, 0, 1);
+}
+
+void graphics_command_recorder::draw_indexed(uint32_t index_start, uint32_t index_count, uint32_t vertex_offset) {
+    draw_indexed(index_start, index_count, vertex_offset, 0, 1);
+}
+
+void graphics_command_recorder::draw_indexed(const graphics_buffer& index_buffer, uint64_t index_offset,
+                                             index_type type, uint32_t index_start, uint32_t index_count,
+                                             uint32_t vertex_offset) {
+    draw_indexed(index_buffer, index_offset, type, index_start, index_count, vertex_offset, 0, 1);
+}
+
+void graphics_command_recorder::draw_indexed(const graphics_buffer& index_buffer, uint64_t index_offset,
+                                             index_type type, uint32_t index_start, uint32_t index_count,
+                                             uint32_t vertex_offset, uint32_t instance_start,
+                                             uint32_t instance_count) {
+    bind_index_buffer(index_buffer, index_offset, type);
+    draw_indexed(index_start, index_count, vertex_offset, instance_start, instance_count);
+}
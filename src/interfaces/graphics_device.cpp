@@ -9,6 +9,10 @@ const graphics_device_def& graphics_device::def() const {
     return *_def;
 }
 
+const graphics_config& graphics_device::config() const {
+    return _config;
+}
+
 int graphics_device::current_frame() const {
     return _current_frame;
 }
@@ -17,4 +21,53 @@ void graphics_device::advance_frame() {
     wait_for_frame();
     _current_frame = (_current_frame + 1) % _config.frames_in_flight;
     frame_changed(_current_frame);
+
+    if (_memory_budget_callback) {
+        auto stats = memory_stats();
+        bool over_budget = false;
+        for (const auto& heap : stats.heaps)
+            if (heap.budget > 0 && (double) heap.usage > (double) heap.budget * _memory_budget_fraction)
+                over_budget = true;
+
+        if (over_budget && !_over_memory_budget) _memory_budget_callback(stats);
+        _over_memory_budget = over_budget;
+    }
+}
+
+void graphics_device::set_memory_budget_callback(float fraction,
+                                                 std::function<void(const graphics_memory_stats&)> callback) {
+    _memory_budget_fraction = fraction;
+    _memory_budget_callback = std::move(callback);
+    _over_memory_budget = false;
+}
+
+result::ptr<graphics_buffer> graphics_device::create_buffer(buffer_usage_flags usage, const void* data,
+                                                            uint64_t size) {
+    auto buffer = GET_OR_FORWARD(create_buffer(usage, size));
+    buffer->write_async(data, size);
+    buffer->make_immutable();
+    return result::ok(buffer.release());
+}
+
+result::ptr<graphics_image> graphics_device::create_image(uint32_t width, uint32_t height,
+                                                          graphics_image_format format, const void* data,
+                                                          uint64_t size) {
+    return create_image({.width = width, .height = height, .format = format}, data, size);
+}
+
+result::ptr<graphics_image> graphics_device::create_image(uint32_t width, uint32_t height,
+                                                          graphics_image_format format) {
+    return create_image({.width = width, .height = height, .format = format});
+}
+
+result::ptr<graphics_image> graphics_device::create_image(const graphics_image_init& init, const void* data,
+                                                          uint64_t size) {
+    auto image = GET_OR_FORWARD(create_image(init));
+    image->write_async(data, size);
+    image->make_immutable();
+    return result::ok(image.release());
+}
+
+void graphics_device::submit_command_buffer(const graphics_command_buffer& command_buffer) {
+    submit({{.command_buffer = &command_buffer, .swapchain = true}});
 }
@@ -0,0 +1,186 @@
+#include "xgraphics/interfaces/graphics_geometry_arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+// The top 16 bits of a handle identify the arena, the next 16 the generation of the slot, and the low 32 the slot
+static std::atomic<uint32_t> next_arena_id = 0;
+
+graphics_geometry_arena::graphics_geometry_arena(buffer_usage_flags usage, uint64_t block_size)
+    : _id(next_arena_id++ & 0xFFFF), _usage(usage), _block_size(block_size) { }
+
+buffer_usage_flags graphics_geometry_arena::usage() const {
+    return _usage;
+}
+
+uint64_t graphics_geometry_arena::block_size() const {
+    return _block_size;
+}
+
+uint32_t graphics_geometry_arena::block_count() const {
+    return (uint32_t) _blocks.size();
+}
+
+result::val<graphics_geometry_handle> graphics_geometry_arena::allocate(uint64_t size, uint32_t alignment) {
+    graphics_geometry_allocation allocation = {
+        .size = size,
+        .alignment = std::max(alignment, 1u),
+        .live = true,
+    };
+
+    bool found = false;
+    for (uint32_t i = 0; i < _blocks.size() && !found; i++) {
+        found = allocate_from(_blocks[i], size, allocation.alignment, allocation.offset);
+        allocation.block = i;
+    }
+
+    if (!found) {
+        // Allocations larger than a block get a block of their own
+        uint64_t block_size = std::max(size, _block_size);
+        auto buffer = GET_OR_FORWARD(create_block(_usage, block_size));
+        _blocks.push_back({std::move(buffer), {{0, block_size}}});
+
+        allocation.block = (uint32_t) _blocks.size() - 1;
+        allocate_from(_blocks.back(), size, allocation.alignment, allocation.offset);
+    }
+
+    // Reused slots keep their generation, which was advanced when they were freed
+    uint32_t index;
+    if (!_free_indices.empty()) {
+        index = _free_indices.back();
+        _free_indices.pop_back();
+        allocation.generation = _allocations[index].generation;
+        _allocations[index] = allocation;
+    } else {
+        index = (uint32_t) _allocations.size();
+        _allocations.push_back(allocation);
+    }
+
+    return result::ok(handle(index));
+}
+
+void graphics_geometry_arena::free(graphics_geometry_handle handle) {
+    uint32_t index = this->index(handle);
+    auto& allocation = _allocations[index];
+    release_to(_blocks[allocation.block], allocation.offset, allocation.size);
+    allocation.live = false;
+    allocation.generation++;
+    _free_indices.push_back(index);
+}
+
+graphics_geometry_slice graphics_geometry_arena::slice(graphics_geometry_handle handle) const {
+    const auto& allocation = _allocations[index(handle)];
+    return {_blocks[allocation.block].buffer.get(), allocation.offset, allocation.size};
+}
+
+void graphics_geometry_arena::write(graphics_geometry_handle handle, const void* data, uint64_t size) {
+    const auto& allocation = _allocations[index(handle)];
+    if (size > allocation.size) throw std::runtime_error("Geometry write is larger than the allocation");
+    _blocks[allocation.block].buffer->write(allocation.offset, data, size);
+}
+
+graphics_transfer_token graphics_geometry_arena::write_async(graphics_geometry_handle handle, const void* data,
+                                                             uint64_t size) {
+    const auto& allocation = _allocations[index(handle)];
+    if (size > allocation.size) throw std::runtime_error("Geometry write is larger than the allocation");
+    return _blocks[allocation.block].buffer->write_async(allocation.offset, data, size);
+}
+
+result::val<uint32_t> graphics_geometry_arena::compact() {
+    // Place the largest allocations first, so that smaller ones fill the space left at the end of each block
+    std::vector<uint32_t> indices;
+    for (uint32_t index = 0; index < _allocations.size(); index++)
+        if (_allocations[index].live) indices.push_back(index);
+    std::sort(indices.begin(), indices.end(), [this](auto a, auto b) {
+        return _allocations[a].size > _allocations[b].size;
+    });
+
+    std::vector<graphics_geometry_block> blocks;
+    std::vector<graphics_geometry_allocation> allocations = _allocations;
+    std::vector<graphics_geometry_copy> copies;
+    for (auto index : indices) {
+        auto& allocation = allocations[index];
+
+        bool found = false;
+        for (uint32_t i = 0; i < blocks.size() && !found; i++) {
+            found = allocate_from(blocks[i], allocation.size, allocation.alignment, allocation.offset);
+            allocation.block = i;
+        }
+
+        if (!found) {
+            uint64_t block_size = std::max(allocation.size, _block_size);
+            auto buffer = GET_OR_FORWARD(create_block(_usage, block_size));
+            blocks.push_back({std::move(buffer), {{0, block_size}}});
+
+            allocation.block = (uint32_t) blocks.size() - 1;
+            allocate_from(blocks.back(), allocation.size, allocation.alignment, allocation.offset);
+        }
+
+        const auto& old_allocation = _allocations[index];
+        copies.push_back({
+            .src = _blocks[old_allocation.block].buffer.get(),
+            .src_offset = old_allocation.offset,
+            .dst = blocks[allocation.block].buffer.get(),
+            .dst_offset = allocation.offset,
+            .size = allocation.size,
+        });
+    }
+
+    copy(copies);
+
+    _blocks = std::move(blocks);
+    _allocations = std::move(allocations);
+    return result::ok(block_count());
+}
+
+graphics_geometry_handle graphics_geometry_arena::handle(uint32_t index) const {
+    return (uint64_t) _id << 48 | (uint64_t) (_allocations[index].generation & 0xFFFF) << 32 | index;
+}
+
+uint32_t graphics_geometry_arena::index(graphics_geometry_handle handle) const {
+    auto index = (uint32_t) handle;
+    if (handle >> 48 != _id || index >= _allocations.size() || !_allocations[index].live ||
+        (handle >> 32 & 0xFFFF) != (_allocations[index].generation & 0xFFFF))
+        throw std::runtime_error("Invalid geometry handle");
+    return index;
+}
+
+bool graphics_geometry_arena::allocate_from(graphics_geometry_block& block, uint64_t size, uint32_t alignment,
+                                            uint64_t& offset) {
+    for (auto it = block.free_ranges.begin(); it != block.free_ranges.end(); it++) {
+        auto [range_offset, range_size] = *it;
+        uint64_t aligned_offset = (range_offset + alignment - 1) / alignment * alignment;
+        if (aligned_offset + size > range_offset + range_size) continue;
+
+        // Keep whatever is left on either side of the allocation
+        block.free_ranges.erase(it);
+        if (aligned_offset > range_offset) block.free_ranges[range_offset] = aligned_offset - range_offset;
+        if (aligned_offset + size < range_offset + range_size)
+            block.free_ranges[aligned_offset + size] = range_offset + range_size - aligned_offset - size;
+
+        offset = aligned_offset;
+        return true;
+    }
+
+    return false;
+}
+
+void graphics_geometry_arena::release_to(graphics_geometry_block& block, uint64_t offset, uint64_t size) {
+    // Merge with the free ranges directly before and after
+    auto next = block.free_ranges.lower_bound(offset);
+    if (next != block.free_ranges.end() && offset + size == next->first) {
+        size += next->second;
+        next = block.free_ranges.erase(next);
+    }
+
+    if (next != block.free_ranges.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            previous->second += size;
+            return;
+        }
+    }
+
+    block.free_ranges[offset] = size;
+}
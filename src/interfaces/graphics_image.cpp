@@ -1,7 +1,33 @@
 #include "xgraphics/interfaces/graphics_image.h"
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
 
-graphics_image::graphics_image(uint32_t width, uint32_t height, graphics_image_format format)
-    : _width(width), _height(height), _format(format) { }
+static uint32_t image_layers(const graphics_image_init& init) {
+    switch (init.type) {
+        case graphics_image_type::image_2d_array:
+            return std::max(init.layers, 1u);
+        case graphics_image_type::cube:
+            return 6;
+        default:
+            return 1;
+    }
+}
+
+static uint32_t image_depth(const graphics_image_init& init) {
+    return init.type == graphics_image_type::image_3d ? std::max(init.depth, 1u) : 1;
+}
+
+graphics_image::graphics_image(const graphics_image_init& init)
+    : _width(init.width),
+      _height(init.height),
+      _depth(image_depth(init)),
+      _layers(image_layers(init)),
+      _format(init.format),
+      _type(init.type),
+      _mip_levels(init.mipmaps ? mip_level_count(init.width, init.height, image_depth(init))
+                               : std::max(init.mip_levels, 1u)),
+      _mipmaps(init.mipmaps) { }
 
 uint32_t graphics_image::width() const {
     return _width;
@@ -11,6 +37,125 @@ uint32_t graphics_image::height() const {
     return _height;
 }
 
+uint32_t graphics_image::depth() const {
+    return _depth;
+}
+
+uint32_t graphics_image::layers() const {
+    return _layers;
+}
+
 graphics_image_format graphics_image::format() const {
     return _format;
-}
\ No newline at end of file
+}
+
+graphics_image_type graphics_image::type() const {
+    return _type;
+}
+
+uint32_t graphics_image::mip_levels() const {
+    return _mip_levels;
+}
+
+bool graphics_image::generates_mipmaps() const {
+    return _mipmaps;
+}
+
+uint32_t graphics_image::level_width(uint32_t mip_level) const {
+    return std::max(_width >> mip_level, 1u);
+}
+
+uint32_t graphics_image::level_height(uint32_t mip_level) const {
+    return std::max(_height >> mip_level, 1u);
+}
+
+uint32_t graphics_image::level_depth(uint32_t mip_level) const {
+    return std::max(_depth >> mip_level, 1u);
+}
+
+uint64_t graphics_image::level_row_pitch(uint32_t mip_level) const {
+    auto info = format_info(_format);
+    uint64_t blocks_wide = (level_width(mip_level) + info.block_width - 1) / info.block_width;
+    return blocks_wide * info.block_size;
+}
+
+uint64_t graphics_image::level_size(uint32_t mip_level) const {
+    auto info = format_info(_format);
+    uint64_t blocks_high = (level_height(mip_level) + info.block_height - 1) / info.block_height;
+    return blocks_high * level_row_pitch(mip_level) * level_depth(mip_level);
+}
+
+uint64_t graphics_image::region_row_pitch(uint32_t width) const {
+    auto info = format_info(_format);
+    return (uint64_t) ((width + info.block_width - 1) / info.block_width) * info.block_size;
+}
+
+uint32_t graphics_image::region_rows(uint32_t height) const {
+    auto info = format_info(_format);
+    return (height + info.block_height - 1) / info.block_height;
+}
+
+void graphics_image::check_region(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t mip_level,
+                                  uint32_t layer) const {
+    if (mip_level >= _mip_levels) throw std::runtime_error("Image mip level is out of range");
+    if (layer >= (_type == graphics_image_type::image_3d ? level_depth(mip_level) : _layers))
+        throw std::runtime_error("Image layer is out of range");
+
+    uint32_t level_width = this->level_width(mip_level);
+    uint32_t level_height = this->level_height(mip_level);
+    if (width == 0 || height == 0 || x > level_width || width > level_width - x || y > level_height ||
+        height > level_height - y)
+        throw std::runtime_error("Image region is out of range");
+
+    auto info = format_info(_format);
+    bool aligned = x % info.block_width == 0 && y % info.block_height == 0 &&
+                   (width % info.block_width == 0 || x + width == level_width) &&
+                   (height % info.block_height == 0 || y + height == level_height);
+    if (!aligned) throw std::runtime_error("Image region is not aligned to the blocks of its format");
+}
+
+bool graphics_image::immutable() const {
+    return _immutable;
+}
+
+void graphics_image::make_immutable() {
+    _immutable = true;
+}
+
+graphics_image_format_info graphics_image::format_info(graphics_image_format format) {
+    switch (format) {
+        case graphics_image_format::rgba_8_srgb:
+        case graphics_image_format::rgba_8_unorm:
+            return {1, 1, 4};
+        case graphics_image_format::bc1_srgb:
+        case graphics_image_format::bc1_unorm:
+        case graphics_image_format::bc4_unorm:
+            return {4, 4, 8};
+        case graphics_image_format::bc3_srgb:
+        case graphics_image_format::bc3_unorm:
+        case graphics_image_format::bc5_unorm:
+        case graphics_image_format::bc7_srgb:
+        case graphics_image_format::bc7_unorm:
+        case graphics_image_format::etc2_rgba_8_srgb:
+        case graphics_image_format::etc2_rgba_8_unorm:
+        case graphics_image_format::astc_4x4_srgb:
+        case graphics_image_format::astc_4x4_unorm:
+            return {4, 4, 16};
+    }
+    return {1, 1, 4};
+}
+
+bool graphics_image::compressed(graphics_image_format format) {
+    return format_info(format).block_width > 1;
+}
+
+uint32_t graphics_image::mip_level_count(uint32_t width, uint32_t height, uint32_t depth) {
+    return std::bit_width(std::max({width, height, depth, 1u}));
+}
+
+bool graphics_image::valid(const graphics_image_init& init) {
+    if (init.width == 0 || init.height == 0) return false;
+    if (init.type == graphics_image_type::cube && init.width != init.height) return false;
+    if (init.type == graphics_image_type::image_3d && compressed(init.format)) return false;
+    return true;
+}
@@ -0,0 +1,7 @@
+#include "xgraphics/interfaces/graphics_readback.h"
+
+graphics_readback::graphics_readback(uint64_t size) : _size(size) { }
+
+uint64_t graphics_readback::size() const {
+    return _size;
+}
@@ -1,4 +1,5 @@
 #include "xgraphics/interfaces/graphics_swapchain.h"
+#include <algorithm>
 
 graphics_swapchain::graphics_swapchain(uint32_t width, uint32_t height) : _width(width), _height(height) { }
 
@@ -14,3 +15,10 @@ void graphics_swapchain::resize(uint32_t width, uint32_t height) {
     _width = width;
     _height = height;
 }
+
+graphics_present_mode graphics_swapchain::choose_present_mode(const std::vector<graphics_present_mode>& preferred,
+                                                              const std::vector<graphics_present_mode>& supported) {
+    for (auto mode : preferred)
+        if (std::find(supported.begin(), supported.end(), mode) != supported.end()) return mode;
+    return graphics_present_mode::fifo;
+}
@@ -0,0 +1,38 @@
+#include "xgraphics/interfaces/graphics_upload_batch.h"
+#include <stdexcept>
+
+void graphics_upload_batch::write(graphics_buffer& buffer, const void* data, uint64_t size) {
+    if (buffer.immutable()) throw std::runtime_error("Cannot write to an immutable buffer");
+    if (size > buffer.size()) throw std::runtime_error("Buffer write is out of range");
+    if (_bytes == 0) _start = std::chrono::steady_clock::now();
+    _bytes += size;
+    record_write(buffer, data, size);
+}
+
+void graphics_upload_batch::write(graphics_image& image, const void* data, uint64_t size) {
+    if (image.immutable()) throw std::runtime_error("Cannot write to an immutable image");
+    if (size != image.level_size(0) * image.layers())
+        throw std::runtime_error("Image write size does not match the level");
+    if (_bytes == 0) _start = std::chrono::steady_clock::now();
+    _bytes += size;
+    record_write(image, data, size);
+}
+
+graphics_transfer_token graphics_upload_batch::submit() {
+    _token = submit_writes();
+    return _token;
+}
+
+void graphics_upload_batch::wait() {
+    wait_for_writes(_token);
+    if (_bytes > 0) _duration = std::chrono::steady_clock::now() - _start;
+}
+
+uint64_t graphics_upload_batch::bytes() const {
+    return _bytes;
+}
+
+double graphics_upload_batch::bytes_per_second() const {
+    auto seconds = std::chrono::duration<double>(_duration).count();
+    return seconds > 0 ? (double) _bytes / seconds : 0;
+}